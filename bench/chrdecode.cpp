@@ -0,0 +1,74 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/chrdecode.hpp"
+#include "../src/nescart.hpp"
+
+// Decodes the full CHR-ROM of a cart (or a synthetic 256K one, the largest
+// iNES 1.0 CHR size) with each decoder and reports the throughput.
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+static double bench(const char *name, size_t tiles, int passes, F decode)
+{
+	const Clock::time_point start = Clock::now();
+	for (int pass = 0; pass < passes; ++pass)
+	{
+		decode();
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	const double tilesPerSecond = tiles * passes / seconds;
+	std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+			  << std::setw(10) << tilesPerSecond / 1e6 << " Mtiles/s "
+			  << std::setw(10) << tilesPerSecond * chrTileBytes / (1 << 20) << " MB/s in" << std::endl;
+	return seconds;
+}
+
+int main(int argc, const char *argv[])
+{
+	std::vector<byte> chr;
+	if (argc > 1)
+	{
+		NESCart cart(argv[1]);
+		chr = cart.chrRom;
+	}
+	if (chr.empty())
+	{
+		chr.resize(32 * chrRomPageSize);
+		std::mt19937 random(1);
+		for (byte &value : chr) value = static_cast<byte>(random());
+	}
+
+	const size_t tiles = chr.size() / chrTileBytes;
+	const int passes = argc > 2 ? std::stoi(argv[2]) : 200;
+	std::vector<byte> scalar(tiles * chrTilePixels), vectorized(tiles * chrTilePixels);
+	std::cout << "CHR: " << chr.size() << " bytes, " << tiles << " tiles, " << passes << " passes" << std::endl;
+
+	bench("rows", tiles, passes, [&]() {
+		for (size_t tile = 0; tile < tiles; ++tile)
+		{
+			for (int row = 0; row < 8; ++row)
+			{
+				const byte *planes = &chr[tile * chrTileBytes];
+				decodeTileRow(planes[row], planes[row + 8], &scalar[tile * chrTilePixels + row * 8]);
+			}
+		}
+	});
+	bench("scalar", tiles, passes, [&]() { decodeTilesScalar(chr.data(), tiles, scalar.data()); });
+#ifdef __SSE2__
+	bench("sse2", tiles, passes, [&]() { decodeTilesSSE2(chr.data(), tiles, vectorized.data()); });
+#endif
+	bench("decodeTiles", tiles, passes, [&]() { decodeTiles(chr.data(), tiles, vectorized.data()); });
+
+	if (scalar != vectorized)
+	{
+		std::cerr << "Decoders disagree" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/core6502.hpp"
+#include "../src/flatbus.hpp"
+#include "../src/opcodelist.hpp"
+
+// Runs every opcode in opcodes.hpp on its own in a tight loop on a flat RAM
+// bus, reporting nanoseconds per instruction and the emulated clock rate,
+// so a slowdown in one addressing mode shows up against its opcodes.
+
+using Clock = std::chrono::steady_clock;
+using Core = mos6502::Core<FlatBus, false>;
+using Mode = mos6502::Addressing::Mode;
+using mos6502::OpcodeInfo;
+
+namespace
+{
+	const char *modeName(Mode mode)
+	{
+		static const char *const names[] = {
+			"Implicit", "Accumulator", "Immediate", "ZeroPage", "ZeroPageX", "ZeroPageY", "Relative",
+			"Absolute", "AbsoluteX", "AbsoluteY", "Indirect", "IndexedIndirect", "IndirectIndexed"
+		};
+		return names[static_cast<int>(mode)];
+	}
+
+	constexpr uint16_t codeStart = 0x0800;
+	constexpr uint16_t codeEnd = 0xf000;
+	constexpr uint16_t dataAddress = 0x0300;
+	constexpr byte zeroPageAddress = 0x10;
+	constexpr byte pointerAddress = 0x20;
+	constexpr byte stackFill = 0x24; // RTS and RTI pop $2424 from a stack full of these
+
+	// Lays the instruction out so it can run forever and returns where to
+	// start. Most are copied back to back up to end, and the loop goes back
+	// to the start from there. Jumps and returns are set up to land on
+	// themselves, leaving end past the top of memory.
+	uint16_t layOut(FlatBus &bus, const OpcodeInfo &opcode, int &end)
+	{
+		std::vector<byte> zeroPage(256, dataAddress & 0xff); // every pointer is $0303
+		bus.load(0x0000, zeroPage.data(), zeroPage.size());
+		const std::vector<byte> stack(256, stackFill);
+		bus.load(0x0100, stack.data(), stack.size());
+
+		const byte self[] = {codeStart & 0xff, codeStart >> 8};
+		int stride = opcode.byteSize;
+		end = 0x10000;
+		switch (opcode.value)
+		{
+			case mos6502::opcodes::BRK::value:
+			{
+				// BRK skips a padding byte, and goes back to the start
+				// through the vector if it doesn't just carry on
+				bus.load(0xfffe, self, sizeof(self));
+				stride = 2;
+				break;
+			}
+			case mos6502::opcodes::JSR::value:
+			case mos6502::opcodes::JMP::Absolute::value:
+			{
+				const byte jump[] = {opcode.value, self[0], self[1]};
+				bus.load(codeStart, jump, sizeof(jump));
+				return codeStart;
+			}
+			case mos6502::opcodes::JMP::Indirect::value:
+			{
+				const byte jump[] = {opcode.value, dataAddress & 0xff, dataAddress >> 8};
+				bus.load(dataAddress, self, sizeof(self));
+				bus.load(codeStart, jump, sizeof(jump));
+				return codeStart;
+			}
+			case mos6502::opcodes::RTI::value:
+			case mos6502::opcodes::RTS::value:
+			{
+				// RTS adds one to the address it pops, RTI doesn't
+				const uint16_t start = stackFill * 0x101 + (opcode.value == mos6502::opcodes::RTS::value);
+				bus.load(start, &opcode.value, 1);
+				return start;
+			}
+		}
+
+		byte instruction[3] = {opcode.value, 0, 0};
+		switch (opcode.mode)
+		{
+			case Mode::ZeroPage:
+			case Mode::ZeroPageX:
+			case Mode::ZeroPageY:
+				instruction[1] = zeroPageAddress;
+				break;
+			case Mode::Absolute:
+			case Mode::AbsoluteX:
+			case Mode::AbsoluteY:
+				instruction[1] = dataAddress & 0xff;
+				instruction[2] = dataAddress >> 8;
+				break;
+			case Mode::IndexedIndirect:
+			case Mode::IndirectIndexed:
+				instruction[1] = pointerAddress;
+				break;
+			default:
+				// immediates are 0 and branches go to the next instruction
+				// whether they're taken or not
+				break;
+		}
+		const int copies = (codeEnd - codeStart) / stride;
+		for (int i = 0; i < copies; ++i)
+		{
+			bus.load(codeStart + i * stride, instruction, opcode.byteSize);
+		}
+		end = codeStart + copies * stride;
+		return codeStart;
+	}
+
+	void bench(const OpcodeInfo &opcode, long instructions)
+	{
+		auto bus = std::make_unique<FlatBus>();
+		int end;
+		const uint16_t start = layOut(*bus, opcode, end);
+		Core cpu(*bus);
+		cpu.reset();
+		cpu.jump(start);
+
+		const long startCycles = cpu.getState().totalCycles;
+		const Clock::time_point startTime = Clock::now();
+		for (long i = 0; i < instructions; ++i)
+		{
+			if (cpu.getState().pc.value >= end)
+			{
+				cpu.jump(start);
+			}
+			cpu.step();
+		}
+		const double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+		const long cycles = cpu.getState().totalCycles - startCycles;
+
+		std::cout << std::setfill(' ') << std::left << std::setw(5) << opcode.name
+				  << std::hex << std::right << std::setfill('0') << std::setw(2) << static_cast<int>(opcode.value)
+				  << std::setfill(' ') << std::dec << "  " << std::left << std::setw(16) << modeName(opcode.mode)
+				  << std::right << std::fixed << std::setprecision(2)
+				  << std::setw(8) << seconds * 1e9 / instructions << " ns"
+				  << std::setw(10) << cycles / seconds / 1e6 << " MHz" << std::endl;
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	const long instructions = argc > 1 ? std::stol(argv[1]) : 2000000;
+	const std::string only = argc > 2 ? argv[2] : std::string();
+	if (instructions <= 0)
+	{
+		std::cerr << "usage: " << argv[0] << " [instructions] [mnemonic]" << std::endl;
+		return 1;
+	}
+
+	for (const OpcodeInfo &opcode : mos6502::allOpcodes())
+	{
+		if (only.empty() || opcode.name == only)
+		{
+			bench(opcode, instructions);
+		}
+	}
+	return 0;
+}
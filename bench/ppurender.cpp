@@ -0,0 +1,55 @@
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+
+#include "../src/framebuffer.hpp"
+#include "../src/nes.hpp"
+#include "../src/nescart.hpp"
+
+// Runs a ROM headless with the PPU rendering whole scanlines and then dot by
+// dot, reporting frames per second for each and whether the frames match.
+
+using Clock = std::chrono::steady_clock;
+
+static double bench(const char *name, const NESCart &cart, bool batched, int frames, FrameBuffer &frame)
+{
+	auto nes = std::make_unique<NES>(cart);
+	nes->setBatchedRendering(batched);
+
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < frames; ++i)
+	{
+		nes->runFrame(frame);
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << std::setfill(' ') << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+			  << std::setw(10) << frames / seconds << " frames/s" << std::endl;
+	return seconds;
+}
+
+int main(int argc, const char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " rom [frames]" << std::endl;
+		return 1;
+	}
+
+	NESCart cart(argv[1]);
+	const int frames = argc > 2 ? std::stoi(argv[2]) : 600;
+	auto batchedFrame = std::make_unique<FrameBuffer>();
+	auto dotFrame = std::make_unique<FrameBuffer>();
+
+	const double batched = bench("scanline", cart, true, frames, *batchedFrame);
+	const double dot = bench("dot", cart, false, frames, *dotFrame);
+	std::cout << "speedup " << std::setprecision(2) << dot / batched << "x" << std::endl;
+
+	if (batchedFrame->pixels != dotFrame->pixels || batchedFrame->emphasis != dotFrame->emphasis)
+	{
+		std::cerr << "Renderers disagree" << std::endl;
+		return 1;
+	}
+	return 0;
+}
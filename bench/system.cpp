@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/framebuffer.hpp"
+#include "../src/inputlog.hpp"
+#include "../src/nes.hpp"
+#include "../src/nescart.hpp"
+
+// Boots every ROM in a directory headless and runs it for a fixed number of
+// frames, printing frames and instructions per second and peak RSS for each
+// as JSON. Each ROM runs in its own child process so its peak RSS is its own.
+//
+// Input comes from a file next to the ROM with the extension .input, one
+// line per frame in FCEUX's "RLDUTSBA" notation for controller 1, released
+// when it runs out as nesebar_batch does. Without one, Start is tapped now
+// and then so the ROM gets past its title screen.
+
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+namespace
+{
+	constexpr int startPeriod = 240;
+	constexpr int startHeld = 10;
+
+	struct RunResult
+	{
+		bool loaded;
+		bool halted;
+		long frames;
+		long instructions;
+		double seconds;
+	};
+
+	std::vector<byte> readInputs(const fs::path &rom, long frames)
+	{
+		fs::path inputPath = rom;
+		std::vector<byte> inputs = readInputLog(inputPath.replace_extension(".input").string());
+		if (inputs.empty())
+		{
+			for (long frame = 0; frame < frames; ++frame)
+			{
+				inputs.push_back(frame % startPeriod >= startPeriod - startHeld ? NESController::Start : 0);
+			}
+		}
+		return inputs;
+	}
+
+	RunResult run(const fs::path &rom, long frames)
+	{
+		RunResult result = {false, false, 0, 0, 0};
+		NESCart cart(rom.string());
+		if (cart.prgRom.empty())
+		{
+			return result;
+		}
+		const std::vector<byte> inputs = readInputs(rom, frames);
+		auto nes = std::make_unique<NES>(cart);
+		auto frame = std::make_unique<FrameBuffer>();
+
+		const Clock::time_point start = Clock::now();
+		for (long i = 0; i < frames; ++i)
+		{
+			nes->setButtons(0, inputForFrame(inputs, i));
+			if (!nes->runFrame(*frame))
+			{
+				result.halted = true;
+				break;
+			}
+		}
+		result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		result.loaded = true;
+		result.frames = frames;
+		result.instructions = nes->instructionCount();
+		return result;
+	}
+
+	// runs the ROM in a child process, returning false if it didn't finish
+	bool runChild(const fs::path &rom, long frames, RunResult &result, long &peakKilobytes)
+	{
+		int channel[2];
+		if (pipe(channel) != 0)
+		{
+			return false;
+		}
+		const pid_t child = fork();
+		if (child < 0)
+		{
+			return false;
+		}
+		if (child == 0)
+		{
+			close(channel[0]);
+			// the cart's header report would end up in the JSON
+			std::cout.setstate(std::ios::failbit);
+			const RunResult childResult = run(rom, frames);
+			const bool written = write(channel[1], &childResult, sizeof(childResult)) == sizeof(childResult);
+			_exit(written ? 0 : 1);
+		}
+
+		close(channel[1]);
+		const bool received = read(channel[0], &result, sizeof(result)) == sizeof(result);
+		close(channel[0]);
+		int status;
+		struct rusage usage;
+		if (wait4(child, &status, 0, &usage) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			return false;
+		}
+		peakKilobytes = usage.ru_maxrss;
+		return received;
+	}
+
+	std::string jsonString(const std::string &text)
+	{
+		std::ostringstream out;
+		out << '"';
+		for (unsigned char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\' << c;
+			}
+			else if (c < 0x20)
+			{
+				out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << '"';
+		return out.str();
+	}
+
+	bool isRom(const fs::path &path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+					   [](unsigned char c) { return std::tolower(c); });
+		return extension == ".nes" || extension == ".gz" || extension == ".zip";
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	char *end = nullptr;
+	const long frames = argc > 2 ? std::strtol(argv[2], &end, 10) : 600;
+	if (argc < 2 || !fs::is_directory(argv[1]) || (end && *end) || frames <= 0)
+	{
+		std::cerr << "usage: " << argv[0] << " rom-directory [frames]" << std::endl;
+		return 1;
+	}
+
+	std::vector<fs::path> roms;
+	for (const fs::directory_entry &entry : fs::directory_iterator(argv[1]))
+	{
+		if (entry.is_regular_file() && isRom(entry.path()))
+		{
+			roms.push_back(entry.path());
+		}
+	}
+	std::sort(roms.begin(), roms.end());
+
+	bool failed = false;
+	std::cout << std::fixed << std::setprecision(1)
+			  << "{\n  \"frames\": " << frames << ",\n  \"roms\": [";
+	for (size_t i = 0; i < roms.size(); ++i)
+	{
+		RunResult result;
+		long peakKilobytes = 0;
+		std::cout << (i ? "," : "") << "\n    {\"rom\": " << jsonString(roms[i].filename().string());
+		if (!runChild(roms[i], frames, result, peakKilobytes) || !result.loaded)
+		{
+			std::cerr << "Can't run " << roms[i].string() << std::endl;
+			std::cout << ", \"error\": true}";
+			failed = true;
+			continue;
+		}
+		if (result.halted)
+		{
+			std::cerr << roms[i].string() << " halted the CPU" << std::endl;
+			std::cout << ", \"error\": true, \"halted\": true}";
+			failed = true;
+			continue;
+		}
+		std::cout << ", \"seconds\": " << std::setprecision(3) << result.seconds
+				  << ", \"fps\": " << std::setprecision(1) << result.frames / result.seconds
+				  << ", \"instructions_per_second\": " << std::setprecision(0) << result.instructions / result.seconds
+				  << ", \"peak_rss_kb\": " << peakKilobytes << "}";
+	}
+	std::cout << "\n  ]\n}" << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "../src/nescart.hpp"
+#include "../src/nesvectorenv.hpp"
+
+// Steps a vector environment of one ROM with changing actions, reporting
+// instance frames per second for RAM and frame observations.
+
+using Clock = std::chrono::steady_clock;
+
+static void bench(const char *name, const NESCart &cart, int instances, int frames, NESVectorEnv::Observation observation)
+{
+	NESVectorEnv env(cart, instances, observation);
+	std::vector<byte> actions(instances);
+	std::vector<byte> observations(instances * env.observationSize());
+
+	const Clock::time_point start = Clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		for (int i = 0; i < instances; ++i)
+		{
+			actions[i] = static_cast<byte>((frame + i) * 37);
+		}
+		env.step(actions.data(), observations.data());
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << std::setfill(' ') << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(1)
+			  << std::setw(10) << instances * frames / seconds << " instance frames/s" << std::endl;
+}
+
+int main(int argc, const char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " rom [instances] [frames]" << std::endl;
+		return 1;
+	}
+
+	NESCart cart(argv[1]);
+	const int instances = argc > 2 ? std::atoi(argv[2]) : 64;
+	const int frames = argc > 3 ? std::atoi(argv[3]) : 60;
+	if (cart.prgRom.empty() || instances <= 0 || frames <= 0)
+	{
+		std::cerr << "usage: " << argv[0] << " rom [instances] [frames]" << std::endl;
+		return 1;
+	}
+	bench("ram", cart, instances, frames, NESVectorEnv::Observation::Ram);
+	bench("frame", cart, instances, frames, NESVectorEnv::Observation::Frame);
+	return 0;
+}
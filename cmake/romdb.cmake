@@ -0,0 +1,59 @@
+# Generates the sorted constexpr ROM database table from data/romdb.txt.
+# Run with -DINPUT=<romdb.txt> -DOUTPUT=<romdb_table.hpp>.
+
+file(STRINGS "${INPUT}" lines)
+
+set(entries "")
+foreach(line IN LISTS lines)
+  string(STRIP "${line}" line)
+  if(line STREQUAL "" OR line MATCHES "^#")
+    continue()
+  endif()
+  if(NOT line MATCHES "^([0-9A-Fa-f]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([HV4-])[ \t]+([01])[ \t]+(NTSC|PAL|MULTI|DENDY)$")
+    message(FATAL_ERROR "${INPUT}: malformed entry \"${line}\"")
+  endif()
+  string(TOLOWER "${CMAKE_MATCH_1}" crc)
+  string(LENGTH "${crc}" length)
+  if(length GREATER 8)
+    message(FATAL_ERROR "${INPUT}: CRC too long in \"${line}\"")
+  endif()
+  # zero pad so the entries sort numerically as strings
+  while(length LESS 8)
+    set(crc "0${crc}")
+    math(EXPR length "${length} + 1")
+  endwhile()
+
+  set(mirroring_H "RomMirroring::Horizontal")
+  set(mirroring_V "RomMirroring::Vertical")
+  set(mirroring_4 "RomMirroring::FourScreen")
+  set(mirroring_- "RomMirroring::Header")
+  set(timing_NTSC "Timing::NTSC")
+  set(timing_PAL "Timing::PAL")
+  set(timing_MULTI "Timing::MultiRegion")
+  set(timing_DENDY "Timing::Dendy")
+  set(battery_0 "false")
+  set(battery_1 "true")
+  list(APPEND entries "${crc}|{0x${crc}, ${CMAKE_MATCH_2}, ${CMAKE_MATCH_3}, ${mirroring_${CMAKE_MATCH_4}}, ${battery_${CMAKE_MATCH_5}}, ${timing_${CMAKE_MATCH_6}}}")
+endforeach()
+
+list(SORT entries)
+list(LENGTH entries count)
+
+set(body "")
+set(previous "")
+foreach(entry IN LISTS entries)
+  string(REPLACE "|" ";" parts "${entry}")
+  list(GET parts 0 crc)
+  list(GET parts 1 initializer)
+  if(crc STREQUAL previous)
+    message(FATAL_ERROR "${INPUT}: duplicate entry for ${crc}")
+  endif()
+  set(previous "${crc}")
+  string(APPEND body "\t${initializer},\n")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"// generated from data/romdb.txt by cmake/romdb.cmake, don't edit\n\n"
+"constexpr std::array<RomDbEntry, ${count}> romDbEntries = {{\n${body}}};\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
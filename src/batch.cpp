@@ -0,0 +1,86 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "batchrunner.hpp"
+#include "inputlog.hpp"
+#include "nescart.hpp"
+
+// Headless batch frontend: runs every ROM given, each as many times as
+// asked, across all cores and prints the hash of the last frame of each
+// run. Input for a ROM is read from a .input file next to it if there is
+// one, see inputlog.hpp.
+
+int main(int argc, const char *argv[])
+{
+	int threads = 0;
+	long frames = 600;
+	int copies = 1;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg(argv[i]);
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			threads = std::stoi(argv[++i]);
+		}
+		else if (arg == "--frames" && i + 1 < argc)
+		{
+			frames = std::stol(argv[++i]);
+		}
+		else if (arg == "--copies" && i + 1 < argc)
+		{
+			copies = std::stoi(argv[++i]);
+		}
+		else
+		{
+			paths.push_back(arg);
+		}
+	}
+	if (paths.empty() || frames <= 0 || copies <= 0)
+	{
+		std::cerr << "usage: " << argv[0] << " [--threads n] [--frames n] [--copies n] rom..." << std::endl;
+		return 1;
+	}
+
+	// carts and inputs are loaded here and shared by every copy
+	std::vector<std::unique_ptr<NESCart>> carts;
+	std::vector<std::vector<byte>> inputs;
+	for (const std::string &path : paths)
+	{
+		carts.push_back(std::make_unique<NESCart>(path));
+		if (carts.back()->prgRom.empty())
+		{
+			std::cerr << "Can't load " << path << std::endl;
+			return 1;
+		}
+		inputs.push_back(readInputLog(std::filesystem::path(path).replace_extension(".input").string()));
+	}
+	std::vector<BatchJob> jobs;
+	for (size_t rom = 0; rom < paths.size(); ++rom)
+	{
+		for (int copy = 0; copy < copies; ++copy)
+		{
+			jobs.push_back({carts[rom].get(), &inputs[rom], frames});
+		}
+	}
+
+	BatchRunner runner(threads);
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<BatchResult> results = runner.run(jobs);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		std::cout << paths[i / copies] << " #" << i % copies << ": " << std::dec << results[i].instructions
+				  << " instructions, last frame " << std::hex << std::setw(16) << std::setfill('0')
+				  << results[i].lastFrameHash << (results[i].halted ? ", CPU halted" : "") << std::endl;
+	}
+	std::cout << std::dec << std::fixed << std::setprecision(1) << jobs.size() << " runs on " << runner.threads()
+			  << " threads in " << seconds << "s, " << jobs.size() * frames / seconds << " frames/s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "batchrunner.hpp"
+#include "framebuffer.hpp"
+#include "inputlog.hpp"
+#include "nes.hpp"
+
+BatchRunner::BatchRunner(int threads)
+{
+	threadCount = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// the back of a worker's own queue, or failing that the front of another's
+bool BatchRunner::takeJob(std::vector<WorkQueue> &queues, size_t own, size_t &job)
+{
+	for (size_t i = 0; i < queues.size(); ++i)
+	{
+		WorkQueue &queue = queues[(own + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			if (i == 0)
+			{
+				job = queue.jobs.back();
+				queue.jobs.pop_back();
+			}
+			else
+			{
+				job = queue.jobs.front();
+				queue.jobs.pop_front();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+BatchResult BatchRunner::runJob(const BatchJob &job, FrameBuffer &frame)
+{
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start = Clock::now();
+
+	auto nes = std::make_unique<NES>(*job.cart);
+	const std::vector<byte> &inputs = *job.inputs;
+	for (long i = 0; i < job.frames; ++i)
+	{
+		nes->setButtons(0, inputForFrame(inputs, i));
+		if (!nes->runFrame(frame))
+		{
+			break;
+		}
+	}
+
+	BatchResult result;
+	result.instructions = nes->instructionCount();
+	result.lastFrameHash = frameHash(frame);
+	result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	result.halted = nes->halted();
+	return result;
+}
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchJob> &jobs)
+{
+	std::vector<BatchResult> results(jobs.size());
+	const size_t workers = std::min<size_t>(threadCount, std::max<size_t>(jobs.size(), 1));
+
+	// dealt out round robin up front, nothing is added once they start
+	std::vector<WorkQueue> queues(workers);
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		queues[i % workers].jobs.push_back(i);
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t worker = 0; worker < workers; ++worker)
+	{
+		threads.emplace_back([&, worker]() {
+			auto frame = std::make_unique<FrameBuffer>();
+			size_t job;
+			while (takeJob(queues, worker, job))
+			{
+				results[job] = runJob(jobs[job], *frame);
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+	return results;
+}
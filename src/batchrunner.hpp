@@ -0,0 +1,59 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "common.hpp"
+#include "framebuffer.hpp"
+#include "nescart.hpp"
+
+// One emulator run: a cart, the controller 1 input for each frame (released
+// once it runs out) and how many frames to run. Carts and inputs aren't
+// copied, many jobs can share them.
+struct BatchJob
+{
+	const NESCart *cart;
+	const std::vector<byte> *inputs;
+	long frames;
+};
+
+// a run whose CPU halted stops there, its last frame being the one it
+// halted in
+struct BatchResult
+{
+	long instructions;
+	uint64_t lastFrameHash;
+	double seconds;
+	bool halted;
+};
+
+// Runs independent jobs across a pool of threads, each of which works
+// through its own queue and steals from the others once it's empty. Workers
+// share nothing but the queues: each builds one NES per job and keeps one
+// frame buffer, and nothing is printed while they run.
+class BatchRunner
+{
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<size_t> jobs;
+	};
+
+	int threadCount;
+
+	static bool takeJob(std::vector<WorkQueue> &queues, size_t own, size_t &job);
+	static BatchResult runJob(const BatchJob &job, FrameBuffer &frame);
+
+public:
+	// threads of 0 uses one per hardware thread
+	explicit BatchRunner(int threads = 0);
+
+	int threads() const { return threadCount; }
+
+	// results are in the same order as the jobs
+	std::vector<BatchResult> run(const std::vector<BatchJob> &jobs);
+};
+
+#endif /* BATCHRUNNER_H */
@@ -0,0 +1,154 @@
+#ifndef BLIPBUFFER_H
+#define BLIPBUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Band-limited step synthesis. Sound sources only report amplitude changes
+// (deltas) at input clock times; each delta is spread over a few output
+// samples with a windowed-sinc impulse, and reading integrates the impulses
+// back into band-limited steps. This keeps the cost proportional to the
+// number of amplitude changes rather than the input clock rate.
+class BlipBuffer
+{
+	static constexpr int phaseBits = 5;
+	static constexpr int phases = 1 << phaseBits;
+	static constexpr int kernelWidth = 16;
+	static constexpr int fracBits = 32;
+	static constexpr double cutoff = 0.9; // fraction of the output Nyquist rate
+	static constexpr double highpassHz = 90.0;
+
+	using Kernel = std::array<std::array<float, kernelWidth>, phases>;
+
+	const Kernel &kernel; // the same for every buffer
+	std::vector<float> buffer; // allocated on first use, copies start without one
+	const int capacity;
+	uint64_t factor; // output samples per input clock, 32.32 fixed point
+	uint64_t offset; // start of the current frame, 32.32 fixed point
+	float integrator, highpass, highpassRate;
+
+	static Kernel buildKernel()
+	{
+		Kernel kernel;
+		const double pi = 3.14159265358979323846;
+		for (int phase = 0; phase < phases; ++phase)
+		{
+			const double frac = static_cast<double>(phase) / phases;
+			double sum = 0;
+			std::array<double, kernelWidth> taps;
+			for (int i = 0; i < kernelWidth; ++i)
+			{
+				const double x = i - (kernelWidth / 2 - 1) - frac;
+				const double sinc = x == 0 ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+				const double w = (x + kernelWidth / 2.0) / kernelWidth; // 0..1 across the kernel
+				const double window = 0.42 - 0.5 * std::cos(2 * pi * w) + 0.08 * std::cos(4 * pi * w);
+				taps[i] = sinc * window;
+				sum += taps[i];
+			}
+			for (int i = 0; i < kernelWidth; ++i)
+			{
+				kernel[phase][i] = static_cast<float>(taps[i] / sum);
+			}
+		}
+		return kernel;
+	}
+
+	static const Kernel &sharedKernel()
+	{
+		static const Kernel kernel = buildKernel();
+		return kernel;
+	}
+
+	void allocate()
+	{
+		if (buffer.empty())
+		{
+			buffer.assign(capacity + kernelWidth, 0.0f);
+		}
+	}
+
+public:
+	BlipBuffer(double clockRate, double sampleRate, int capacity)
+		: kernel(sharedKernel()), capacity(capacity), offset(0), integrator(0), highpass(0)
+	{
+		factor = static_cast<uint64_t>(sampleRate / clockRate * (uint64_t(1) << fracBits));
+		highpassRate = static_cast<float>(1.0 - std::exp(-2 * 3.14159265358979323846 * highpassHz / sampleRate));
+	}
+
+	// A copy drops the samples nobody has read yet rather than copying the
+	// buffer. Their deltas go into the integrator, so the copy's output picks
+	// up at the level the original's reaches, without the steps' ringing.
+	BlipBuffer(const BlipBuffer &other)
+		: kernel(other.kernel), capacity(other.capacity), factor(other.factor),
+		  offset(other.offset & ((uint64_t(1) << fracBits) - 1)), integrator(other.integrator),
+		  highpass(other.highpass), highpassRate(other.highpassRate)
+	{
+		for (float delta : other.buffer)
+		{
+			integrator += delta;
+		}
+	}
+
+	BlipBuffer &operator=(const BlipBuffer &) = delete;
+
+	// time is in input clocks since the start of the current frame
+	void addDelta(uint32_t time, float delta)
+	{
+		const uint64_t position = offset + time * factor;
+		const int index = static_cast<int>(position >> fracBits);
+		const int phase = static_cast<int>(position >> (fracBits - phaseBits)) & (phases - 1);
+		allocate();
+		float *out = &buffer[index];
+		const std::array<float, kernelWidth> &taps = kernel[phase];
+		for (int i = 0; i < kernelWidth; ++i)
+		{
+			out[i] += taps[i] * delta;
+		}
+	}
+
+	// ends the current frame after duration input clocks, making its samples
+	// readable; samples nobody reads are dropped once the buffer fills up
+	void endFrame(uint32_t duration)
+	{
+		offset += duration * factor;
+		const int overflow = samplesAvailable() - capacity / 2;
+		if (overflow > 0)
+		{
+			readSamples(nullptr, overflow);
+		}
+	}
+
+	int samplesAvailable() const
+	{
+		return static_cast<int>(offset >> fracBits);
+	}
+
+	// out may be null to discard samples
+	int readSamples(int16_t *out, int count)
+	{
+		count = std::min(count, samplesAvailable());
+		allocate();
+		for (int i = 0; i < count; ++i)
+		{
+			integrator += buffer[i];
+			highpass += (integrator - highpass) * highpassRate;
+			if (out)
+			{
+				const float sample = std::clamp(integrator - highpass, -32768.0f, 32767.0f);
+				out[i] = static_cast<int16_t>(sample);
+			}
+		}
+
+		const int remaining = samplesAvailable() - count + kernelWidth;
+		std::memmove(buffer.data(), buffer.data() + count, remaining * sizeof(float));
+		std::fill(buffer.begin() + remaining, buffer.begin() + remaining + count, 0.0f);
+		offset -= static_cast<uint64_t>(count) << fracBits;
+		return count;
+	}
+};
+
+#endif /* BLIPBUFFER_H */
@@ -0,0 +1,120 @@
+#ifndef BREAKPOINTS_H
+#define BREAKPOINTS_H
+
+#include <array>
+#include <bitset>
+#include "memaddress.hpp"
+
+namespace mos6502
+{
+
+// breakpoints are only checked with NESEBAR_DEBUGGER defined, and then only
+// while some are attached to the CPU, see Core::setBreakpoints
+#ifdef NESEBAR_DEBUGGER
+constexpr bool debuggerEnabled = true;
+#else
+constexpr bool debuggerEnabled = false;
+#endif
+
+// Execution breakpoints and read and write watchpoints, a bit per address
+// for each. An execution breakpoint stops the CPU before the instruction
+// runs; a watchpoint lets the access and the rest of its instruction finish
+// and stops before the next one. Only the first hit is kept until resume().
+class Breakpoints
+{
+public:
+	enum Kind
+	{
+		Execute,
+		Read,
+		Write,
+		kindCount
+	};
+
+private:
+	std::array<std::bitset<0x10000>, kindCount> bits;
+	std::array<int, kindCount> counts;
+	bool stopped;
+	Kind stopKind;
+	MemAddress stopAddress;
+	bool resuming;
+	MemAddress resumeAddress;
+
+public:
+	Breakpoints() : counts(), stopped(false), stopKind(Execute), resuming(false) {}
+
+	void set(Kind kind, const MemAddress &address)
+	{
+		if (!bits[kind][address.value])
+		{
+			bits[kind].set(address.value);
+			++counts[kind];
+		}
+	}
+
+	void clear(Kind kind, const MemAddress &address)
+	{
+		if (bits[kind][address.value])
+		{
+			bits[kind].reset(address.value);
+			--counts[kind];
+		}
+	}
+
+	bool isSet(Kind kind, const MemAddress &address) const { return bits[kind][address.value]; }
+	int count(Kind kind) const { return counts[kind]; }
+	bool armed() const { return counts[Execute] + counts[Read] + counts[Write] > 0; }
+
+	// called by the CPU before each instruction, true when it should stop
+	bool atExecute(const MemAddress &pc)
+	{
+		if (resuming && pc.value == resumeAddress.value)
+		{
+			resuming = false;
+			return false;
+		}
+		resuming = false;
+		if (bits[Execute][pc.value])
+		{
+			hit(Execute, pc);
+			return true;
+		}
+		return stopped;
+	}
+
+	// called by the CPU for every read and write it makes
+	void access(Kind kind, const MemAddress &address)
+	{
+		if (bits[kind][address.value])
+		{
+			hit(kind, address);
+		}
+	}
+
+	void hit(Kind kind, const MemAddress &address)
+	{
+		if (!stopped)
+		{
+			stopped = true;
+			stopKind = kind;
+			stopAddress = address;
+		}
+	}
+
+	bool isStopped() const { return stopped; }
+	Kind stoppedBy() const { return stopKind; }
+	const MemAddress &stoppedAt() const { return stopAddress; }
+
+	// carries on from a stop, not stopping again for an execution
+	// breakpoint at pc before its instruction has run
+	void resume(const MemAddress &pc)
+	{
+		stopped = false;
+		resuming = true;
+		resumeAddress = pc;
+	}
+};
+
+}
+
+#endif /* BREAKPOINTS_H */
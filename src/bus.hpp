@@ -0,0 +1,33 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <type_traits>
+#include <utility>
+#include "common.hpp"
+#include "memaddress.hpp"
+
+namespace mos6502
+{
+	// A bus is whatever the CPU is wired to. Core takes it as a template
+	// argument so every access is a direct, inlinable call:
+	//
+	//   byte read(const MemAddress &address)              CPU read, side effects allowed
+	//   void write(const MemAddress &address, byte value) CPU write
+	//   byte peek(const MemAddress &address) const        read without side effects,
+	//                                                     for tracing and debuggers
+	template<typename Bus, typename = void>
+	struct IsBus : std::false_type
+	{
+	};
+
+	template<typename Bus>
+	struct IsBus<Bus, std::void_t<
+		decltype(static_cast<byte>(std::declval<Bus &>().read(std::declval<const MemAddress &>()))),
+		decltype(std::declval<Bus &>().write(std::declval<const MemAddress &>(), byte())),
+		decltype(static_cast<byte>(std::declval<const Bus &>().peek(std::declval<const MemAddress &>())))>>
+		: std::true_type
+	{
+	};
+}
+
+#endif /* BUS_H */
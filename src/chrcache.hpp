@@ -0,0 +1,147 @@
+#ifndef CHRCACHE_H
+#define CHRCACHE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "chrdecode.hpp"
+#include "common.hpp"
+#include "cowmemory.hpp"
+
+// Pattern table memory as the PPU sees it, through eight 1K bank windows,
+// along with every CHR tile pre-decoded to one byte per pixel. The cache
+// covers all of CHR rather than just the mapped banks so switching a bank is
+// only a window change; writes to CHR-RAM mark their tile dirty and it's
+// decoded again the next time a row of it is fetched.
+//
+// Copies share CHR-ROM and its decoding, and share CHR-RAM and its decoding
+// copy on write a bank at a time.
+class ChrCache
+{
+	static constexpr int bankSize = 0x400;
+	static constexpr int bankCount = 8;
+	static constexpr int bankTiles = bankSize / chrTileBytes;
+	static constexpr int decodedBankSize = bankTiles * chrTilePixels;
+
+	const byte *rom; // null when CHR is RAM
+	std::shared_ptr<const std::vector<byte>> romDecoded;
+	CowMemory<bankSize> ram;
+	CowMemory<decodedBankSize> ramDecoded;
+	std::vector<byte> dirty;
+	uint32_t banks;
+
+	// what each window shows, kept pointing at pages this copy holds
+	std::array<uint32_t, bankCount> windowBank;
+	std::array<const byte *, bankCount> window;
+	std::array<const byte *, bankCount> windowDecoded;
+
+	void updateWindow(int slot)
+	{
+		const uint32_t bank = windowBank[slot];
+		if (rom)
+		{
+			window[slot] = rom + bank * bankSize;
+			windowDecoded[slot] = romDecoded->data() + bank * decodedBankSize;
+		}
+		else
+		{
+			window[slot] = ram.page(bank);
+			windowDecoded[slot] = ramDecoded.page(bank);
+		}
+	}
+
+	void updateWindows()
+	{
+		for (int slot = 0; slot < bankCount; ++slot)
+		{
+			updateWindow(slot);
+		}
+	}
+
+	void mapBanks(size_t size)
+	{
+		banks = size > bankSize ? size / bankSize : 1;
+		for (int bank = 0; bank < bankCount; ++bank)
+		{
+			setBank(bank, bank);
+		}
+	}
+
+public:
+	ChrCache() : rom(nullptr), banks(0), windowBank(), window(), windowDecoded() {}
+
+	void load(const byte *chrRom, size_t size)
+	{
+		rom = chrRom;
+		const size_t tiles = size / chrTileBytes;
+		auto decoded = std::make_shared<std::vector<byte>>(tiles * chrTilePixels);
+		decodeTiles(rom, tiles, decoded->data());
+		romDecoded = std::move(decoded);
+		ram = CowMemory<bankSize>();
+		ramDecoded = CowMemory<decodedBankSize>();
+		dirty.assign(tiles, 0);
+		mapBanks(size);
+	}
+
+	// size bytes of CHR-RAM, zeroed, which decodes to all zero pixels
+	void loadRam(size_t size)
+	{
+		rom = nullptr;
+		romDecoded.reset();
+		ram = CowMemory<bankSize>(size);
+		ramDecoded = CowMemory<decodedBankSize>(ram.size() / bankSize * decodedBankSize);
+		dirty.assign(ram.size() / chrTileBytes, 0);
+		mapBanks(size);
+	}
+
+	// maps 1K window slot ($0000-$1FFF in 1K steps) to CHR bank
+	void setBank(int slot, int bank)
+	{
+		windowBank[slot] = static_cast<uint32_t>(bank) % banks;
+		updateWindow(slot);
+	}
+
+	byte read(uint16_t address) const
+	{
+		return window[(address >> 10) & (bankCount - 1)][address & (bankSize - 1)];
+	}
+
+	void write(uint16_t address, byte value)
+	{
+		if (!rom)
+		{
+			const int slot = (address >> 10) & (bankCount - 1);
+			const uint32_t offset = address & (bankSize - 1);
+			byte *page = ram.writablePage(windowBank[slot]);
+			page[offset] = value;
+			dirty[windowBank[slot] * bankTiles + offset / chrTileBytes] = 1;
+			if (page != window[slot])
+			{
+				updateWindows();
+			}
+		}
+	}
+
+	// decoded pixels of the tile row whose low plane byte is at address
+	const byte *tileRow(uint16_t address)
+	{
+		const int slot = (address >> 10) & (bankCount - 1);
+		const uint32_t offset = address & (bankSize - 1);
+		const uint32_t tile = offset / chrTileBytes;
+		const uint32_t dirtyTile = windowBank[slot] * bankTiles + tile;
+		if (dirty[dirtyTile])
+		{
+			byte *page = ramDecoded.writablePage(windowBank[slot]);
+			decodeTilesScalar(window[slot] + tile * chrTileBytes, 1, page + tile * chrTilePixels);
+			dirty[dirtyTile] = 0;
+			if (page != windowDecoded[slot])
+			{
+				updateWindows();
+			}
+		}
+		return windowDecoded[slot] + tile * chrTilePixels + (offset & 0x07) * 8;
+	}
+};
+
+#endif /* CHRCACHE_H */
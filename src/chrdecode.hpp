@@ -0,0 +1,116 @@
+#ifndef CHRDECODE_H
+#define CHRDECODE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "common.hpp"
+
+// CHR pattern data stores each 8x8 tile as two bit planes of 8 bytes, the
+// low plane first. Decoding interleaves the planes into one byte per pixel
+// holding the 2-bit colour, leftmost pixel first.
+
+constexpr int chrTileBytes = 16;
+constexpr int chrTilePixels = 64;
+
+namespace chr_detail
+{
+	// spreads the bits of a byte into the bytes of a little endian word,
+	// bit 7 ending up in the lowest byte
+	struct SpreadTable
+	{
+		std::array<uint64_t, 256> rows;
+
+		constexpr SpreadTable() : rows()
+		{
+			for (int value = 0; value < 256; ++value)
+			{
+				uint64_t row = 0;
+				for (int pixel = 0; pixel < 8; ++pixel)
+				{
+					row |= static_cast<uint64_t>((value >> (7 - pixel)) & 1) << (pixel * 8);
+				}
+				rows[value] = row;
+			}
+		}
+	};
+
+	constexpr SpreadTable spread;
+}
+
+inline void decodeTileRow(byte low, byte high, byte *out)
+{
+	const uint64_t row = chr_detail::spread.rows[low] | (chr_detail::spread.rows[high] << 1);
+	std::memcpy(out, &row, sizeof(row));
+}
+
+inline void decodeTilesScalar(const byte *chr, size_t tiles, byte *out)
+{
+	for (size_t tile = 0; tile < tiles; ++tile, chr += chrTileBytes, out += chrTilePixels)
+	{
+		for (int row = 0; row < 8; ++row)
+		{
+			decodeTileRow(chr[row], chr[row + 8], out + row * 8);
+		}
+	}
+}
+
+#ifdef __SSE2__
+namespace chr_detail
+{
+	// rows holds a plane byte repeated across each 8 byte half; masking with
+	// the bit each pixel tests and clamping to 1 gives that pixel's plane bit
+	inline __m128i planeBits(__m128i rows, __m128i bits)
+	{
+		return _mm_min_epu8(_mm_and_si128(rows, bits), _mm_set1_epi8(1));
+	}
+
+	inline void storeRows(byte *out, __m128i lowRows, __m128i highRows, __m128i bits)
+	{
+		const __m128i high = planeBits(highRows, bits);
+		const __m128i pixels = _mm_add_epi8(planeBits(lowRows, bits), _mm_add_epi8(high, high));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), pixels);
+	}
+}
+
+// Each plane byte is broadcast across the 8 bytes of its row with unpacks,
+// two rows to a register, so a tile takes four stores.
+inline void decodeTilesSSE2(const byte *chr, size_t tiles, byte *out)
+{
+	using namespace chr_detail;
+	const __m128i bits = _mm_set_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+									  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80));
+
+	for (size_t tile = 0; tile < tiles; ++tile, chr += chrTileBytes, out += chrTilePixels)
+	{
+		const __m128i planes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chr));
+		const __m128i low2 = _mm_unpacklo_epi8(planes, planes);
+		const __m128i high2 = _mm_unpackhi_epi8(planes, planes);
+		const __m128i low4a = _mm_unpacklo_epi16(low2, low2);
+		const __m128i low4b = _mm_unpackhi_epi16(low2, low2);
+		const __m128i high4a = _mm_unpacklo_epi16(high2, high2);
+		const __m128i high4b = _mm_unpackhi_epi16(high2, high2);
+
+		storeRows(out, _mm_unpacklo_epi32(low4a, low4a), _mm_unpacklo_epi32(high4a, high4a), bits);
+		storeRows(out + 16, _mm_unpackhi_epi32(low4a, low4a), _mm_unpackhi_epi32(high4a, high4a), bits);
+		storeRows(out + 32, _mm_unpacklo_epi32(low4b, low4b), _mm_unpacklo_epi32(high4b, high4b), bits);
+		storeRows(out + 48, _mm_unpackhi_epi32(low4b, low4b), _mm_unpackhi_epi32(high4b, high4b), bits);
+	}
+}
+#endif
+
+// decodes whole tiles, chrTilePixels bytes of output per tile
+inline void decodeTiles(const byte *chr, size_t tiles, byte *out)
+{
+#ifdef __SSE2__
+	decodeTilesSSE2(chr, tiles, out);
+#else
+	decodeTilesScalar(chr, tiles, out);
+#endif
+}
+
+#endif /* CHRDECODE_H */
@@ -3,46 +3,45 @@
 #include <vector>
 #include "core6502.hpp"
 #include "flags.hpp"
+#include "flatbus.hpp"
 #include "nesmemory.hpp"
 #include "opcodes.hpp"
 
 using namespace mos6502;
 
-template<typename Memory, typename Mapping, bool DecimalMode>
-Core<Memory, Mapping, DecimalMode>::Core(const Mapping &mapping) : memory(state, mapping), mapping(mapping)
+template<typename Bus, bool DecimalMode>
+Core<Bus, DecimalMode>::Core(Bus &bus) : memory(state, bus)
 {
-	memory.write(0x4017, 0); // frame IRQ enable
-	memory.write(0x4015, 0); // disable all channels
+}
 
-	for (MemAddress addr = 0x4000; addr <= 0x400f; ++addr)
-	{
-		memory.write(addr, 0);
-	}
-	for (MemAddress addr = 0x4010; addr <= 0x4013; ++addr)
-	{
-		memory.write(addr, 0);
-	}
+template<typename Bus, bool DecimalMode>
+Core<Bus, DecimalMode>::Core(const Core &other, Bus &bus) : state(other.state), memory(state, bus)
+{
 }
 
-template<typename Memory, typename Mapping, bool DecimalMode>
-void Core<Memory, Mapping, DecimalMode>::step()
+template<typename Bus, bool DecimalMode>
+bool Core<Bus, DecimalMode>::step()
 {
 	using namespace mos6502::opcodes;
 
-	logInfo();
-	std::cout << '$' << std::hex << std::setfill('0')
-			  << std::setw(4) << state.pc.value << ": ";
+	if (state.halted)
+	{
+		return false;
+	}
 
-	byte error1 = memory.read(0x02);
-	byte error2 = memory.read(0x03);
-	if (error1 != 0 || error2 != 0)
+	if constexpr (debuggerEnabled)
 	{
-		std::cout << std::endl << std::hex << "Error at $02 = "
-					<< std::setw(2) << static_cast<int>(memory.read(0x02)) << std::endl;
-		std::cout << std::endl << std::hex << "Error at $03 = "
-					<< std::setw(2) << static_cast<int>(memory.read(0x03)) << std::endl;
-		exit(1);
+		Breakpoints *breakpoints = memory.getBreakpoints();
+		if (breakpoints && breakpoints->atExecute(state.pc))
+		{
+			return false;
+		}
 	}
+
+	logInfo();
+	trace << '$' << std::hex << std::setfill('0')
+			  << std::setw(4) << state.pc.value << ": ";
+
 	const byte opcode = nextOpcode();
 	switch (opcode)
 	{
@@ -1581,26 +1580,56 @@ void Core<Memory, Mapping, DecimalMode>::step()
 		}
 		default:
 		{
-			std::cout << std::endl << std::hex << "Unsupported opcode \""
-					  << std::setw(2) << static_cast<int>(opcode)
-					  << "\", stopping." << std::endl;
-			exit(1);
-			break;
+			// JAM and the few unofficial opcodes not implemented stop the CPU
+			// on the opcode, the way a JAM locks up the real one
+			trace << std::setw(2) << static_cast<int>(opcode) << " unsupported, halting" << std::endl;
+			state.pc = state.pc - 1;
+			state.halted = true;
+			return false;
 		}
 	}
-	std::cout << std::endl;
+	trace << std::endl;
+	return true;
 }
 
-template<typename Memory, typename Mapping, bool DecimalMode>
-void Core<Memory, Mapping, DecimalMode>::interruptReset()
+template<typename Bus, bool DecimalMode>
+void Core<Bus, DecimalMode>::interruptReset()
 {
 	state.opcodeResult = 0;
+	state.halted = false;
 	state.sp = -3; // cycle 0: sp = 0, then gets decremented 3 times, look more into this
 	state.p = 0x24; // TODO: Properly configure the status flags
 	state.pc = memory.readMemAddress(0xfffc);
-	//state.pc = 0xc000; // TODO: This is only for nestest.nes "auto mode"
 
 	state.totalCycles = 7;
 }
 
-template class mos6502::Core<Mem6502<NESMemory>, NESMemory, false>;
+template<typename Bus, bool DecimalMode>
+void Core<Bus, DecimalMode>::interruptRequest()
+{
+	if (isStatus(Status::InterruptDisable))
+	{
+		return;
+	}
+	stackPushAddress(state.pc);
+	stackPush((state.p & ~status_bits::B) | status_bits::E);
+	updateStatus(Status::InterruptDisable, true);
+	state.pc = memory.readMemAddress(0xfffe);
+
+	state.totalCycles += 7;
+}
+
+template<typename Bus, bool DecimalMode>
+void Core<Bus, DecimalMode>::interruptNMI()
+{
+	stackPushAddress(state.pc);
+	stackPush((state.p & ~status_bits::B) | status_bits::E);
+	updateStatus(Status::InterruptDisable, true);
+	state.pc = memory.readMemAddress(0xfffa);
+
+	state.totalCycles += 7;
+}
+
+template class mos6502::Core<NESMemory, false>;
+template class mos6502::Core<FlatBus, false>;
+template class mos6502::Core<FlatBus, true>;
@@ -7,11 +7,14 @@
 #include <cstdint>
 #include <vector>
 
+#include "bus.hpp"
 #include "common.hpp"
+#include "decimaltable.hpp"
 #include "flags.hpp"
 #include "mem6502.hpp"
 #include "memaddress.hpp"
 #include "state.hpp"
+#include "trace.hpp"
 
 namespace mos6502
 {
@@ -33,18 +36,19 @@ constexpr auto status_int(const Status status)
 	return static_cast<short>(status);
 }
 
-template<typename Memory, typename Mapping, bool DecimalMode>
+template<typename Bus, bool DecimalMode>
 class Core
 {
+	static_assert(IsBus<Bus>::value, "Core needs a bus with read, write and peek, see bus.hpp");
+
 	static constexpr unsigned int stackStart = 0x0100;
 
 	State state;
-	Memory memory;
-	const Mapping &mapping;
+	Mem6502<Bus> memory;
 
 	void logInfo()
 	{
-		std::cout << std::hex << std::uppercase
+		trace << std::hex << std::uppercase
 				  << "A:" << std::setw(2) << static_cast<int>(state.a)
 				  << "\tX:" << std::setw(2) << static_cast<int>(state.x)
 				  << "\tY:" << std::setw(2) << static_cast<int>(state.y)
@@ -105,7 +109,7 @@ class Core
 		}
 		else
 		{
-			exit(EXIT_FAILURE); // invalid addressing mode
+			static_assert(sizeof(Opcode) == 0, "perform doesn't take this addressing mode");
 		}
 		endInstruction<Opcode, addPageCrossCycles>();
 	}
@@ -118,7 +122,7 @@ class Core
 		state.cycles = T::cycles;
 		state.byteStep = T::byteSize;
 
-		std::cout << std::setw(2) << (int)T::value << ' ' << T::name << std::flush;
+		trace << std::setw(2) << (int)T::value << ' ' << T::name << std::flush;
 	}
 
 	constexpr inline void setOperands(const byte operand1, const byte operand2)
@@ -289,14 +293,8 @@ class Core
 				uint16_t sum = operand1 + operand2 + isStatus(Status::Carry);
 				updateStatus(Status::Carry, sum > 0xff);
 			}
-			if constexpr (checkBit<autoFlags, Status::Unused>())
-			{
-				exit(1);
-			}
-			if constexpr (checkBit<autoFlags, Status::BreakCommand>())
-			{
-				exit(1);
-			}
+			static_assert(!checkBit<autoFlags, Status::Unused>() && !checkBit<autoFlags, Status::BreakCommand>(),
+						  "no opcode sets the unused or break bits from its result");
 			if constexpr (checkBit<autoFlags, Status::ZeroResult>())
 			{
 				updateStatus(Status::ZeroResult, state.opcodeResult == 0);
@@ -331,40 +329,59 @@ class Core
 		}
 	}
 
-	// arithmetic
+	// arithmetic, setting all of N, V, Z and C themselves since decimal mode
+	// doesn't take them all from the result
+	inline void setArithmeticResult(byte result, bool overflow, bool carry)
+	{
+		state.setA(result);
+		updateStatus(Status::NegativeResult, checkBit(result, Status::NegativeResult));
+		updateStatus(Status::ZeroResult, result == 0);
+		updateStatus(Status::Overflow, overflow);
+		updateStatus(Status::Carry, carry);
+	}
+	inline void setDecimalResult(uint16_t entry)
+	{
+		namespace sb = status_bits;
+		constexpr byte flags = sb::N|sb::V|sb::Z|sb::C;
+		state.setA(entry & 0xff);
+		state.p = (state.p & ~flags) | ((entry >> 8) & flags);
+	}
 	inline void adc(byte value)
 	{
-		if constexpr(DecimalMode)
+		const bool carry = isStatus(Status::Carry);
+		if constexpr (DecimalMode)
 		{
-			// TODO: Decimal mode for other systems
-		}
-		else
-		{
-			byte operand = state.a;
-			setOperands(operand, value);
-			byte carry = static_cast<int>(isStatus(Status::Carry));
-			state.setA(operand + value + carry);
-
-			// figure out if there is carry from addition
-			uint16_t sum = operand + value + isStatus(Status::Carry);
-			updateStatus(Status::Carry, sum > 0xff);
+			if (isStatus(Status::DecimalMode))
+			{
+				setDecimalResult(DecimalTable::get().adc(carry, state.a, value));
+				return;
+			}
 		}
+		const byte operand = state.a;
+		const uint16_t sum = operand + value + carry;
+
+		// overflow only occurs if operands have the same sign
+		constexpr byte signBit = 0b10000000;
+		const bool isOverflow = ~(operand ^ value) & (operand ^ sum) & signBit;
+		setArithmeticResult(sum, isOverflow, sum > 0xff);
 	}
 	inline void sbc(byte value)
 	{
-		byte minuhend = state.a;
-		byte subtrahend = value;
-		byte carry = static_cast<int>(isStatus(Status::Carry));
-
-		int16_t difference = minuhend - subtrahend - (1 - carry);
-		state.setA(difference);
-
-		// figure out if there is carry from subtraction
-		updateStatus(Status::Carry, difference >= 0);
+		const bool carry = isStatus(Status::Carry);
+		if constexpr (DecimalMode)
+		{
+			if (isStatus(Status::DecimalMode))
+			{
+				setDecimalResult(DecimalTable::get().sbc(carry, state.a, value));
+				return;
+			}
+		}
+		const byte minuhend = state.a;
+		const int16_t difference = minuhend - value - (1 - carry);
 
 		constexpr byte signBit = 0b10000000;
-		const bool isOverflow = (minuhend ^ subtrahend) & (minuhend ^ state.opcodeResult) & signBit;
-		updateStatus(Status::Overflow, isOverflow);
+		const bool isOverflow = (minuhend ^ value) & (minuhend ^ difference) & signBit;
+		setArithmeticResult(difference, isOverflow, difference >= 0);
 	}
 	
 	inline void dcp(const MemAccess &access)
@@ -427,13 +444,29 @@ class Core
 
 	// interrupts
 	void interruptReset();
+	void interruptRequest();
+	void interruptNMI();
 
 public:
-	Core(const Mapping &mapping);
+	Core(Bus &bus);
+	// a copy of other's state, on its own bus
+	Core(const Core &other, Bus &bus);
 
-	Memory &getMemory() { return memory; }
+	const State &getState() const { return state; }
+	void setState(const State &state) { this->state = state; }
 	void reset() { interruptReset(); }
-	void step();
+	void irq() { interruptRequest(); }
+	void nmi() { interruptNMI(); }
+	void stall(int cycles) { state.totalCycles += cycles; }
+	void jump(const MemAddress &address) { state.pc = address; }
+
+	// breakpoints to check while stepping, only with NESEBAR_DEBUGGER
+	// defined, null for none. A copy of the core starts without any.
+	void setBreakpoints(Breakpoints *breakpoints) { memory.setBreakpoints(breakpoints); }
+
+	// runs one instruction, returns false without running it when the CPU
+	// is stopped at a breakpoint or halted, see State::halted
+	bool step();
 };
 
 };
@@ -0,0 +1,69 @@
+#ifndef COWMEMORY_H
+#define COWMEMORY_H
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "common.hpp"
+
+// Memory in fixed size pages that copies share until one of them writes to a
+// page, which then gets a page of its own. Reads go straight through a table
+// of page pointers; a write first makes sure nobody else holds the page.
+// Copying one costs the page tables, not the memory.
+template <size_t PageSize>
+class CowMemory
+{
+	using Page = std::array<byte, PageSize>;
+
+	std::vector<std::shared_ptr<Page>> owners;
+	std::vector<byte *> pages;
+
+	void own(size_t page)
+	{
+		// a copy that let go of the page in the meantime only costs a clone
+		if (owners[page].use_count() > 1)
+		{
+			owners[page] = std::make_shared<Page>(*owners[page]);
+			pages[page] = owners[page]->data();
+		}
+	}
+
+public:
+	static constexpr size_t pageSize = PageSize;
+
+	// size bytes of zeroes, rounded up to whole pages, which all start out as
+	// the same page
+	explicit CowMemory(size_t size = 0)
+	{
+		const size_t count = (size + PageSize - 1) / PageSize;
+		if (count)
+		{
+			const auto zeroes = std::make_shared<Page>();
+			owners.assign(count, zeroes);
+			pages.assign(count, zeroes->data());
+		}
+	}
+
+	size_t size() const { return pages.size() * PageSize; }
+
+	byte operator[](size_t offset) const
+	{
+		return pages[offset / PageSize][offset % PageSize];
+	}
+
+	void write(size_t offset, byte value)
+	{
+		writablePage(offset / PageSize)[offset % PageSize] = value;
+	}
+
+	const byte *page(size_t page) const { return pages[page]; }
+
+	// the page to write to, which can move when it was shared
+	byte *writablePage(size_t page)
+	{
+		own(page);
+		return pages[page];
+	}
+};
+
+#endif /* COWMEMORY_H */
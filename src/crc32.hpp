@@ -0,0 +1,69 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "common.hpp"
+
+// CRC-32 as used by zip and the ROM databases (reflected, polynomial
+// 0xEDB88320), computed 8 bytes at a time with slicing-by-8 tables.
+
+namespace crc32_detail
+{
+	struct Tables
+	{
+		std::array<std::array<uint32_t, 256>, 8> slices;
+
+		constexpr Tables() : slices()
+		{
+			for (uint32_t value = 0; value < 256; ++value)
+			{
+				uint32_t crc = value;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+				}
+				slices[0][value] = crc;
+			}
+			// each further slice is the CRC of a byte followed by that many zeros
+			for (int slice = 1; slice < 8; ++slice)
+			{
+				for (int value = 0; value < 256; ++value)
+				{
+					const uint32_t previous = slices[slice - 1][value];
+					slices[slice][value] = (previous >> 8) ^ slices[0][previous & 0xff];
+				}
+			}
+		}
+	};
+
+	constexpr Tables tables;
+}
+
+// crc continues an earlier call, so data can be hashed in pieces
+inline uint32_t calculateCRC32(const byte *data, size_t size, uint32_t crc = 0)
+{
+	const auto &slices = crc32_detail::tables.slices;
+	crc = ~crc;
+	for (; size >= 8; data += 8, size -= 8)
+	{
+		uint32_t low, high;
+		std::memcpy(&low, data, 4);
+		std::memcpy(&high, data + 4, 4);
+		// the tables assume little endian words
+		low ^= crc;
+		crc = slices[7][low & 0xff] ^ slices[6][(low >> 8) & 0xff] ^
+			slices[5][(low >> 16) & 0xff] ^ slices[4][low >> 24] ^
+			slices[3][high & 0xff] ^ slices[2][(high >> 8) & 0xff] ^
+			slices[1][(high >> 16) & 0xff] ^ slices[0][high >> 24];
+	}
+	for (; size > 0; ++data, --size)
+	{
+		crc = (crc >> 8) ^ slices[0][(crc ^ *data) & 0xff];
+	}
+	return ~crc;
+}
+
+#endif /* CRC32_H */
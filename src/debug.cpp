@@ -0,0 +1,231 @@
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "debugger.hpp"
+#include "gdbstub.hpp"
+#include "nes.hpp"
+#include "nescart.hpp"
+
+// Console debugger: runs a ROM under commands read from stdin, see help
+// below. Continuing stops at a breakpoint or, on Ctrl-C, at the end of the
+// frame. With --gdb port it serves a GDB client on localhost instead, see
+// gdbstub.hpp.
+
+namespace
+{
+	volatile std::sig_atomic_t interrupted = 0;
+
+	void onInterrupt(int)
+	{
+		interrupted = 1;
+	}
+
+	const char *help =
+		"s [n]        step n instructions, 1 by default\n"
+		"c [frames]   continue until a breakpoint, Ctrl-C or that many frames\n"
+		"b addr       break when the instruction at addr is about to run\n"
+		"rw addr      stop after an instruction that reads addr\n"
+		"w addr       stop after an instruction that writes addr\n"
+		"d addr       delete every breakpoint at addr\n"
+		"l            list breakpoints\n"
+		"r            show the CPU registers\n"
+		"m addr [n]   dump n bytes of memory from addr, 64 by default\n"
+		"q            quit\n";
+
+	bool parseAddress(std::istringstream &args, MemAddress &address)
+	{
+		std::string text;
+		if (!(args >> text))
+		{
+			return false;
+		}
+		if (text[0] == '$')
+		{
+			text.erase(0, 1);
+		}
+		try
+		{
+			address = static_cast<uint16_t>(std::stoul(text, nullptr, 16));
+		}
+		catch (const std::exception &)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	void printState(NES &nes)
+	{
+		const mos6502::State &state = nes.cpuState();
+		std::cout << std::hex << std::uppercase << std::setfill('0') << "PC:" << std::setw(4) << state.pc.value
+				  << " A:" << std::setw(2) << static_cast<int>(state.a) << " X:" << std::setw(2)
+				  << static_cast<int>(state.x) << " Y:" << std::setw(2) << static_cast<int>(state.y) << " P:"
+				  << std::setw(2) << static_cast<int>(state.p) << " SP:" << std::setw(2)
+				  << static_cast<int>(state.sp) << std::dec << " CYC:" << state.totalCycles << std::endl;
+	}
+
+	void printStop(Debugger &debugger)
+	{
+		const mos6502::Breakpoints &breakpoints = debugger.getBreakpoints();
+		static const char *const reasons[] = {"Breakpoint", "Read watchpoint", "Write watchpoint"};
+		const char *reason = debugger.halted() ? "CPU halted" : reasons[breakpoints.stoppedBy()];
+		const MemAddress &at = debugger.halted() ? debugger.machine().cpuState().pc : breakpoints.stoppedAt();
+		std::cout << reason << " at $" << std::hex << std::uppercase << std::setfill('0')
+				  << std::setw(4) << at.value << std::endl;
+		printState(debugger.machine());
+	}
+
+	void dump(NES &nes, MemAddress address, int count)
+	{
+		std::cout << std::hex << std::uppercase << std::setfill('0');
+		for (int i = 0; i < count; ++i, ++address)
+		{
+			if (i % 16 == 0)
+			{
+				std::cout << (i ? "\n" : "") << std::setw(4) << address.value << ':';
+			}
+			std::cout << ' ' << std::setw(2) << static_cast<int>(nes.peek(address));
+		}
+		std::cout << std::dec << std::endl;
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	int gdbPort = -1;
+	std::string path;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg(argv[i]);
+		if (arg == "--gdb" && i + 1 < argc)
+		{
+			gdbPort = std::stoi(argv[++i]);
+		}
+		else
+		{
+			path = arg;
+		}
+	}
+	if (path.empty())
+	{
+		std::cerr << "usage: " << argv[0] << " [--gdb port] rom" << std::endl;
+		return 1;
+	}
+	NESCart cart(path);
+	auto nes = std::make_unique<NES>(cart);
+	Debugger debugger(*nes);
+
+	if (gdbPort >= 0)
+	{
+		GdbStub stub(debugger);
+		if (!stub.listen(gdbPort))
+		{
+			return 1;
+		}
+		std::cout << "Waiting for GDB on port " << stub.port() << std::endl;
+		stub.serve();
+		return 0;
+	}
+
+	std::signal(SIGINT, onInterrupt);
+
+	printState(*nes);
+	std::string line;
+	while (std::cout << "> " << std::flush, std::getline(std::cin, line))
+	{
+		std::istringstream args(line);
+		std::string command;
+		if (!(args >> command))
+		{
+			continue;
+		}
+		MemAddress address;
+		if (command == "s")
+		{
+			long count = 1;
+			args >> count;
+			if (debugger.step(count))
+			{
+				printState(*nes);
+			}
+			else
+			{
+				printStop(debugger);
+			}
+		}
+		else if (command == "c")
+		{
+			long frames = -1;
+			args >> frames;
+			interrupted = 0;
+			bool stopped = false;
+			for (long frame = 0; (frames < 0 || frame < frames) && !interrupted && !stopped; ++frame)
+			{
+				stopped = !debugger.runFrames(1);
+			}
+			if (stopped)
+			{
+				printStop(debugger);
+			}
+			else
+			{
+				printState(*nes);
+			}
+		}
+		else if ((command == "b" || command == "rw" || command == "w" || command == "d") && parseAddress(args, address))
+		{
+			if (command == "d")
+			{
+				for (int kind = 0; kind < mos6502::Breakpoints::kindCount; ++kind)
+				{
+					debugger.clearBreakpoint(static_cast<Debugger::Kind>(kind), address);
+				}
+			}
+			else
+			{
+				debugger.setBreakpoint(command == "b" ? mos6502::Breakpoints::Execute
+									   : command == "rw" ? mos6502::Breakpoints::Read
+									   : mos6502::Breakpoints::Write, address);
+			}
+		}
+		else if (command == "l")
+		{
+			static const char *const names[] = {"b", "rw", "w"};
+			const mos6502::Breakpoints &breakpoints = debugger.getBreakpoints();
+			std::cout << std::hex << std::uppercase << std::setfill('0');
+			for (int kind = 0; kind < mos6502::Breakpoints::kindCount; ++kind)
+			{
+				for (uint32_t value = 0; value < 0x10000; ++value)
+				{
+					if (breakpoints.isSet(static_cast<Debugger::Kind>(kind), static_cast<uint16_t>(value)))
+					{
+						std::cout << names[kind] << " $" << std::setw(4) << value << '\n';
+					}
+				}
+			}
+			std::cout << std::dec << std::flush;
+		}
+		else if (command == "r")
+		{
+			printState(*nes);
+		}
+		else if (command == "m" && parseAddress(args, address))
+		{
+			int count = 64;
+			args >> count;
+			dump(*nes, address, count);
+		}
+		else if (command == "q")
+		{
+			break;
+		}
+		else
+		{
+			std::cout << help;
+		}
+	}
+	return 0;
+}
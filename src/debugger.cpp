@@ -0,0 +1,56 @@
+#include "debugger.hpp"
+
+Debugger::Debugger(NES &nes) : nes(nes), frame(std::make_unique<FrameBuffer>())
+{
+	static_assert(mos6502::debuggerEnabled, "the CPU only checks breakpoints when built with NESEBAR_DEBUGGER");
+}
+
+Debugger::~Debugger()
+{
+	nes.setBreakpoints(nullptr);
+}
+
+void Debugger::attach()
+{
+	nes.setBreakpoints(breakpoints.armed() ? &breakpoints : nullptr);
+}
+
+void Debugger::setBreakpoint(Kind kind, const MemAddress &address)
+{
+	breakpoints.set(kind, address);
+	attach();
+}
+
+void Debugger::clearBreakpoint(Kind kind, const MemAddress &address)
+{
+	breakpoints.clear(kind, address);
+	attach();
+}
+
+bool Debugger::step(long count)
+{
+	// a breakpoint where the CPU stopped doesn't stop it again
+	breakpoints.resume(nes.cpuState().pc);
+	for (long i = 0; i < count; ++i)
+	{
+		nes.step(*frame);
+		if (breakpoints.isStopped() || nes.halted())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Debugger::runFrames(long frames)
+{
+	breakpoints.resume(nes.cpuState().pc);
+	for (long i = 0; i < frames; ++i)
+	{
+		if (!nes.runFrame(*frame))
+		{
+			return false;
+		}
+	}
+	return true;
+}
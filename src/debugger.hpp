@@ -0,0 +1,48 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <memory>
+#include "breakpoints.hpp"
+#include "framebuffer.hpp"
+#include "nes.hpp"
+
+// Drives a NES for a debugging frontend, an instruction or a frame at a
+// time, stopping at breakpoints. The breakpoints are only attached to the CPU
+// while there are any, so without them even a NESEBAR_DEBUGGER build runs
+// the machine with nothing more than a null check per access.
+class Debugger
+{
+	NES &nes;
+	mos6502::Breakpoints breakpoints;
+	std::unique_ptr<FrameBuffer> frame;
+
+	void attach();
+
+public:
+	using Kind = mos6502::Breakpoints::Kind;
+
+	explicit Debugger(NES &nes);
+	~Debugger();
+	Debugger(const Debugger &) = delete;
+	Debugger &operator=(const Debugger &) = delete;
+
+	void setBreakpoint(Kind kind, const MemAddress &address);
+	void clearBreakpoint(Kind kind, const MemAddress &address);
+	const mos6502::Breakpoints &getBreakpoints() const { return breakpoints; }
+
+	// runs count instructions, false if a breakpoint or a halted CPU
+	// stopped them first
+	bool step(long count = 1);
+
+	// runs to the end of the frame being drawn and frames - 1 more, false if
+	// a breakpoint or a halted CPU stopped it first
+	bool runFrames(long frames = 1);
+
+	// whether the CPU has halted, see NES::halted; nothing runs after that
+	bool halted() const { return nes.halted(); }
+
+	NES &machine() { return nes; }
+	const FrameBuffer &picture() const { return *frame; }
+};
+
+#endif /* DEBUGGER_H */
@@ -0,0 +1,104 @@
+#ifndef DECIMALTABLE_H
+#define DECIMALTABLE_H
+
+#include <array>
+#include <cstdint>
+#include "common.hpp"
+#include "flags.hpp"
+
+namespace mos6502
+{
+	// NMOS decimal mode ADC and SBC for every carry, A and operand, indexed
+	// by carry << 16 | a << 8 | operand. Each entry holds the result in its
+	// low byte and the N, V, Z and C flags in its high byte.
+	//
+	// ADC takes Z from the binary sum and N and V from the sum after the low
+	// digit is adjusted but before the high one is, SBC takes all its flags
+	// from the binary difference. Invalid BCD digits give what the NMOS 6502
+	// gives, following the "Decimal Mode" tutorial's appendix on 6502.org.
+	class DecimalTable
+	{
+		static constexpr size_t entries = 2 * 256 * 256;
+
+		std::array<uint16_t, entries> adcTable;
+		std::array<uint16_t, entries> sbcTable;
+
+		static size_t index(bool carry, byte a, byte operand)
+		{
+			return (carry << 16) | (a << 8) | operand;
+		}
+
+		static uint16_t entry(int result, bool n, bool v, bool z, bool c)
+		{
+			namespace sb = status_bits;
+			const byte flags = (n ? sb::N : 0) | (v ? sb::V : 0) | (z ? sb::Z : 0) | (c ? sb::C : 0);
+			return (flags << 8) | (result & 0xff);
+		}
+
+		static uint16_t add(int a, int b, int carry)
+		{
+			int low = (a & 0x0f) + (b & 0x0f) + carry;
+			if (low >= 0x0a)
+			{
+				low = ((low + 0x06) & 0x0f) + 0x10;
+			}
+			int sum = (a & 0xf0) + (b & 0xf0) + low;
+			const int signedSum = static_cast<signed_byte>(a & 0xf0) + static_cast<signed_byte>(b & 0xf0) + low;
+			const bool n = sum & 0x80;
+			const bool v = signedSum < -128 || signedSum > 127;
+			if (sum >= 0xa0)
+			{
+				sum += 0x60;
+			}
+			return entry(sum, n, v, ((a + b + carry) & 0xff) == 0, sum >= 0x100);
+		}
+
+		static uint16_t subtract(int a, int b, int carry)
+		{
+			int low = (a & 0x0f) - (b & 0x0f) + carry - 1;
+			if (low < 0)
+			{
+				low = ((low - 0x06) & 0x0f) - 0x10;
+			}
+			int difference = (a & 0xf0) - (b & 0xf0) + low;
+			if (difference < 0)
+			{
+				difference -= 0x60;
+			}
+			const int binary = a - b + carry - 1;
+			const bool v = (a ^ b) & (a ^ binary) & 0x80;
+			return entry(difference, binary & 0x80, v, (binary & 0xff) == 0, binary >= 0);
+		}
+
+		DecimalTable()
+		{
+			for (int carry = 0; carry < 2; ++carry)
+			{
+				for (int a = 0; a < 256; ++a)
+				{
+					for (int b = 0; b < 256; ++b)
+					{
+						adcTable[index(carry, a, b)] = add(a, b, carry);
+						sbcTable[index(carry, a, b)] = subtract(a, b, carry);
+					}
+				}
+			}
+		}
+
+	public:
+		DecimalTable(const DecimalTable &) = delete;
+		DecimalTable &operator=(const DecimalTable &) = delete;
+
+		// built the first time decimal mode is used
+		static const DecimalTable &get()
+		{
+			static const DecimalTable table;
+			return table;
+		}
+
+		uint16_t adc(bool carry, byte a, byte operand) const { return adcTable[index(carry, a, operand)]; }
+		uint16_t sbc(bool carry, byte a, byte operand) const { return sbcTable[index(carry, a, operand)]; }
+	};
+}
+
+#endif /* DECIMALTABLE_H */
@@ -0,0 +1,31 @@
+#ifndef FLATBUS_H
+#define FLATBUS_H
+
+#include <cstddef>
+#include "common.hpp"
+#include "memaddress.hpp"
+#include "memchunk.hpp"
+
+// 64K of plain RAM and nothing else, for running the 6502 core on its own
+class FlatBus
+{
+	MemChunk<byte, 0x10000> memory;
+
+public:
+	byte read(const MemAddress &address) { return memory[address]; }
+	void write(const MemAddress &address, byte value) { memory[address] = value; }
+	byte peek(const MemAddress &address) const { return memory.data()[address.value]; }
+
+	// copies size bytes to start, wrapping at the top of memory
+	void load(const MemAddress &start, const byte *data, size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			memory.data()[(start.value + i) & 0xffff] = data[i];
+		}
+	}
+
+	const byte *pageData(byte page) const { return &memory.data()[page << 8]; }
+};
+
+#endif /* FLATBUS_H */
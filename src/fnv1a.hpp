@@ -0,0 +1,21 @@
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#include <cstddef>
+#include <cstdint>
+#include "common.hpp"
+
+constexpr uint64_t fnv1aOffset = 0xcbf29ce484222325;
+
+// 64-bit FNV-1a, not for anything adversarial but quick and good enough for
+// telling RAM and frames apart in logs. Chain calls by passing the last hash.
+inline uint64_t fnv1a(const byte *data, size_t size, uint64_t hash = fnv1aOffset)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ data[i]) * 0x100000001b3;
+	}
+	return hash;
+}
+
+#endif /* FNV1A_H */
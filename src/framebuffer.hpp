@@ -0,0 +1,33 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <array>
+#include <cstdint>
+#include "common.hpp"
+#include "fnv1a.hpp"
+
+constexpr int screenWidth = 256;
+constexpr int screenHeight = 240;
+
+// What the PPU outputs: one 6-bit palette index per pixel, plus the PPUMASK
+// colour emphasis bits for each scanline. Conversion to RGB is left to the
+// presentation side (see nespalette.hpp).
+struct FrameBuffer
+{
+	std::array<byte, screenWidth * screenHeight> pixels;
+	std::array<byte, screenHeight> emphasis;
+
+	byte &at(int x, int y)
+	{
+		return pixels[y * screenWidth + x];
+	}
+};
+
+// 64-bit FNV-1a of the pixels and emphasis bits, for telling frames apart in
+// regression runs and logs
+inline uint64_t frameHash(const FrameBuffer &frame)
+{
+	return fnv1a(frame.emphasis.data(), frame.emphasis.size(), fnv1a(frame.pixels.data(), frame.pixels.size()));
+}
+
+#endif /* FRAMEBUFFER_H */
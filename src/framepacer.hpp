@@ -0,0 +1,40 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+#include <thread>
+
+constexpr double ntscFrameRate = 60.0988;
+constexpr double palFrameRate = 50.0070;
+
+// Paces the emulation thread against a high resolution clock instead of the
+// display's vsync.
+class FramePacer
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::duration framePeriod;
+	Clock::time_point deadline;
+
+public:
+	FramePacer(double frameRate)
+		: framePeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRate))),
+		  deadline(Clock::now())
+	{
+	}
+
+	void wait()
+	{
+		deadline += framePeriod;
+		const Clock::time_point now = Clock::now();
+		if (now > deadline + framePeriod * 4)
+		{
+			// fell too far behind (debugger, window drag), don't try to catch up
+			deadline = now;
+			return;
+		}
+		std::this_thread::sleep_until(deadline);
+	}
+};
+
+#endif /* FRAMEPACER_H */
@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "gdbstub.hpp"
+
+namespace
+{
+	constexpr char interruptByte = 0x03;
+	constexpr int registerCount = 6;
+	constexpr int pcRegister = 5;
+
+	const char *const targetXml =
+		"<?xml version=\"1.0\"?>"
+		"<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+		"<target version=\"1.0\">"
+		"<feature name=\"org.nesebar.mos6502\">"
+		"<reg name=\"a\" bitsize=\"8\" type=\"uint8\"/>"
+		"<reg name=\"x\" bitsize=\"8\" type=\"uint8\"/>"
+		"<reg name=\"y\" bitsize=\"8\" type=\"uint8\"/>"
+		"<reg name=\"p\" bitsize=\"8\" type=\"uint8\"/>"
+		"<reg name=\"sp\" bitsize=\"8\" type=\"uint8\"/>"
+		"<reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>"
+		"</feature>"
+		"</target>";
+
+	std::string hexByte(byte value)
+	{
+		static const char digits[] = "0123456789abcdef";
+		return {digits[value >> 4], digits[value & 0x0f]};
+	}
+
+	// the number at the start of text in hex, with where it ended in next
+	unsigned long parseHex(const std::string &text, size_t start, size_t &next)
+	{
+		unsigned long value = 0;
+		next = start;
+		while (next < text.size() && std::isxdigit(static_cast<unsigned char>(text[next])))
+		{
+			const char digit = std::tolower(static_cast<unsigned char>(text[next]));
+			value = value * 16 + (std::isdigit(static_cast<unsigned char>(digit)) ? digit - '0' : digit - 'a' + 10);
+			++next;
+		}
+		return value;
+	}
+
+	bool parseBytes(const std::string &hex, std::vector<byte> &out)
+	{
+		if (hex.size() % 2)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < hex.size(); i += 2)
+		{
+			size_t end;
+			out.push_back(static_cast<byte>(parseHex(hex.substr(i, 2), 0, end)));
+			if (end != 2)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+GdbStub::GdbStub(Debugger &debugger) : debugger(debugger), listener(-1), client(-1), acks(true)
+{
+}
+
+GdbStub::~GdbStub()
+{
+	if (client >= 0)
+	{
+		close(client);
+	}
+	if (listener >= 0)
+	{
+		close(listener);
+	}
+}
+
+bool GdbStub::listen(int port)
+{
+	listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+	{
+		std::cerr << "Can't create a socket for GDB" << std::endl;
+		return false;
+	}
+	const int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener, 1) != 0)
+	{
+		std::cerr << "Can't listen for GDB on port " << port << std::endl;
+		close(listener);
+		listener = -1;
+		return false;
+	}
+	return true;
+}
+
+int GdbStub::port() const
+{
+	sockaddr_in address = {};
+	socklen_t length = sizeof(address);
+	if (listener < 0 || getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+	{
+		return -1;
+	}
+	return ntohs(address.sin_port);
+}
+
+// blocks for more input, false once the client has gone
+bool GdbStub::receive()
+{
+	char buffer[4096];
+	const ssize_t count = recv(client, buffer, sizeof(buffer), 0);
+	if (count <= 0)
+	{
+		close(client);
+		client = -1;
+		return false;
+	}
+	input.append(buffer, count);
+	return true;
+}
+
+bool GdbStub::readPacket(std::string &packet)
+{
+	while (client >= 0)
+	{
+		// acks, stray interrupts and line noise before a packet are dropped
+		const size_t start = input.find('$');
+		if (start == std::string::npos)
+		{
+			input.clear();
+		}
+		else
+		{
+			input.erase(0, start);
+			const size_t end = input.find('#');
+			if (end != std::string::npos && end + 2 < input.size())
+			{
+				packet = input.substr(1, end - 1);
+				size_t next;
+				const unsigned long checksum = parseHex(input.substr(end + 1, 2), 0, next);
+				input.erase(0, end + 3);
+
+				byte sum = 0;
+				for (char c : packet)
+				{
+					sum += static_cast<byte>(c);
+				}
+				if (sum == checksum || !acks)
+				{
+					if (acks)
+					{
+						send(client, "+", 1, MSG_NOSIGNAL);
+					}
+					return true;
+				}
+				send(client, "-", 1, MSG_NOSIGNAL);
+				continue;
+			}
+		}
+		if (!receive())
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+void GdbStub::sendPacket(const std::string &data)
+{
+	byte sum = 0;
+	for (char c : data)
+	{
+		sum += static_cast<byte>(c);
+	}
+	const std::string packet = "$" + data + "#" + hexByte(sum);
+	send(client, packet.data(), packet.size(), MSG_NOSIGNAL);
+}
+
+// checks without blocking whether the client has asked the machine to stop
+bool GdbStub::interrupted()
+{
+	pollfd descriptor = {client, POLLIN, 0};
+	if (poll(&descriptor, 1, 0) > 0 && !receive())
+	{
+		return true;
+	}
+	const size_t found = input.find(interruptByte);
+	if (found != std::string::npos)
+	{
+		input.erase(found, 1);
+		return true;
+	}
+	return false;
+}
+
+std::string GdbStub::stopReply() const
+{
+	// a halted CPU stops as if on an illegal instruction
+	if (debugger.halted())
+	{
+		return "S04";
+	}
+	const mos6502::Breakpoints &breakpoints = debugger.getBreakpoints();
+	if (breakpoints.isStopped() && breakpoints.stoppedBy() != mos6502::Breakpoints::Execute)
+	{
+		const MemAddress &address = breakpoints.stoppedAt();
+		const char *kind = breakpoints.stoppedBy() == mos6502::Breakpoints::Read ? "rwatch:" : "watch:";
+		return std::string("T05") + kind + hexByte(address.value >> 8) + hexByte(address.value & 0xff) + ";";
+	}
+	return "S05";
+}
+
+std::string GdbStub::resume(bool step)
+{
+	if (step)
+	{
+		debugger.step();
+		return stopReply();
+	}
+	while (debugger.runFrames())
+	{
+		if (interrupted())
+		{
+			return "S02";
+		}
+	}
+	return stopReply();
+}
+
+std::string GdbStub::readRegisters() const
+{
+	const mos6502::State &state = debugger.machine().cpuState();
+	return hexByte(state.a) + hexByte(state.x) + hexByte(state.y) + hexByte(state.p) + hexByte(state.sp)
+		   + hexByte(state.pc.value & 0xff) + hexByte(state.pc.value >> 8);
+}
+
+bool GdbStub::writeRegister(int number, const std::string &hex)
+{
+	std::vector<byte> value;
+	if (number < 0 || number >= registerCount || !parseBytes(hex, value)
+		|| value.size() != (number == pcRegister ? 2u : 1u))
+	{
+		return false;
+	}
+	mos6502::State state = debugger.machine().cpuState();
+	byte *const registers[] = {&state.a, &state.x, &state.y, &state.p, &state.sp};
+	if (number == pcRegister)
+	{
+		state.pc = MemAddress(value[0], value[1]);
+	}
+	else
+	{
+		*registers[number] = value[0];
+	}
+	debugger.machine().setCpuState(state);
+	return true;
+}
+
+std::string GdbStub::handle(const std::string &packet, bool &detach)
+{
+	NES &nes = debugger.machine();
+	const char command = packet.empty() ? 0 : packet[0];
+	size_t next;
+	switch (command)
+	{
+		case '?':
+		{
+			return debugger.halted() ? "S04" : "S05";
+		}
+		case 'g':
+		{
+			return readRegisters();
+		}
+		case 'G':
+		{
+			const std::string hex = packet.substr(1);
+			if (hex.size() != 14)
+			{
+				return "E01";
+			}
+			for (int number = 0; number < registerCount; ++number)
+			{
+				writeRegister(number, hex.substr(number * 2, number == pcRegister ? 4 : 2));
+			}
+			return "OK";
+		}
+		case 'p':
+		{
+			const unsigned long number = parseHex(packet, 1, next);
+			const std::string registers = readRegisters();
+			if (number >= registerCount)
+			{
+				return "E01";
+			}
+			return registers.substr(number * 2, number == pcRegister ? 4 : 2);
+		}
+		case 'P':
+		{
+			const unsigned long number = parseHex(packet, 1, next);
+			if (next >= packet.size() || packet[next] != '=')
+			{
+				return "E01";
+			}
+			return writeRegister(number, packet.substr(next + 1)) ? "OK" : "E01";
+		}
+		case 'm':
+		{
+			const unsigned long address = parseHex(packet, 1, next);
+			const unsigned long length = parseHex(packet, next + 1, next);
+			std::string reply;
+			for (unsigned long i = 0; i < length; ++i)
+			{
+				reply += hexByte(nes.peek(static_cast<uint16_t>(address + i)));
+			}
+			return reply;
+		}
+		case 'M':
+		{
+			const unsigned long address = parseHex(packet, 1, next);
+			const unsigned long length = parseHex(packet, next + 1, next);
+			std::vector<byte> data;
+			if (next >= packet.size() || packet[next] != ':' || !parseBytes(packet.substr(next + 1), data)
+				|| data.size() != length)
+			{
+				return "E01";
+			}
+			for (unsigned long i = 0; i < length; ++i)
+			{
+				nes.poke(static_cast<uint16_t>(address + i), data[i]);
+			}
+			return "OK";
+		}
+		case 'c':
+		case 's':
+		{
+			if (packet.size() > 1)
+			{
+				nes.jump(static_cast<uint16_t>(parseHex(packet, 1, next)));
+			}
+			return resume(command == 's');
+		}
+		case 'Z':
+		case 'z':
+		{
+			const unsigned long type = parseHex(packet, 1, next);
+			const unsigned long address = parseHex(packet, next + 1, next);
+			const unsigned long length = parseHex(packet, next + 1, next);
+			using Kind = mos6502::Breakpoints::Kind;
+			std::vector<Kind> kinds;
+			switch (type)
+			{
+				case 0:
+				case 1:
+					kinds = {Kind::Execute};
+					break;
+				case 2:
+					kinds = {Kind::Write};
+					break;
+				case 3:
+					kinds = {Kind::Read};
+					break;
+				case 4:
+					kinds = {Kind::Read, Kind::Write};
+					break;
+				default:
+					return "";
+			}
+			// watchpoints cover length bytes, breakpoints just their address
+			const unsigned long count = type < 2 ? 1 : std::max(length, 1ul);
+			for (Kind kind : kinds)
+			{
+				for (unsigned long i = 0; i < count; ++i)
+				{
+					const MemAddress at = static_cast<uint16_t>(address + i);
+					if (command == 'Z')
+					{
+						debugger.setBreakpoint(kind, at);
+					}
+					else
+					{
+						debugger.clearBreakpoint(kind, at);
+					}
+				}
+			}
+			return "OK";
+		}
+		case 'H':
+		case 'T':
+		{
+			return "OK";
+		}
+		case 'D':
+		{
+			detach = true;
+			return "OK";
+		}
+		case 'k':
+		{
+			detach = true;
+			return "";
+		}
+	}
+
+	if (packet.compare(0, 10, "qSupported") == 0)
+	{
+		return "PacketSize=1000;qXfer:features:read+;QStartNoAckMode+";
+	}
+	if (packet == "QStartNoAckMode" || packet == "qAttached")
+	{
+		return packet == "qAttached" ? "1" : "OK";
+	}
+	if (packet == "qfThreadInfo")
+	{
+		return "m1";
+	}
+	if (packet == "qsThreadInfo")
+	{
+		return "l";
+	}
+	if (packet == "qC")
+	{
+		return "QC1";
+	}
+	const std::string features = "qXfer:features:read:target.xml:";
+	if (packet.compare(0, features.size(), features) == 0)
+	{
+		const size_t offset = parseHex(packet, features.size(), next);
+		const size_t length = parseHex(packet, next + 1, next);
+		const std::string xml(targetXml);
+		if (offset >= xml.size())
+		{
+			return "l";
+		}
+		const std::string chunk = xml.substr(offset, length);
+		return (offset + chunk.size() < xml.size() ? "m" : "l") + chunk;
+	}
+	// anything else isn't supported, which an empty reply says
+	return "";
+}
+
+void GdbStub::serve()
+{
+	client = accept(listener, nullptr, nullptr);
+	if (client < 0)
+	{
+		std::cerr << "Can't accept a GDB connection" << std::endl;
+		return;
+	}
+	acks = true;
+	input.clear();
+
+	std::string packet;
+	bool detach = false;
+	while (!detach && readPacket(packet))
+	{
+		const std::string reply = handle(packet, detach);
+		if (packet != "k")
+		{
+			sendPacket(reply);
+		}
+		if (packet == "QStartNoAckMode")
+		{
+			acks = false;
+		}
+	}
+	if (client >= 0)
+	{
+		close(client);
+		client = -1;
+	}
+}
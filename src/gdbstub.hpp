@@ -0,0 +1,49 @@
+#ifndef GDBSTUB_H
+#define GDBSTUB_H
+
+#include <string>
+#include "debugger.hpp"
+
+// A GDB remote serial protocol server for a machine under a Debugger, over
+// TCP on localhost. serve() is the machine's run loop for as long as a
+// client is attached: packets are only handled while the CPU is halted, and
+// a continue checks the connection for an interrupt once a frame, so the
+// running machine pays nothing for the stub.
+//
+// The registers are a, x, y, p, sp and a 16-bit pc, described to the client
+// through target.xml. Memory reads are peeks, which leave I/O registers
+// alone and read them as 0; memory writes are CPU writes.
+class GdbStub
+{
+	Debugger &debugger;
+	int listener;
+	int client;
+	bool acks;
+	std::string input; // received bytes not handled yet
+
+	bool receive();
+	bool readPacket(std::string &packet);
+	void sendPacket(const std::string &data);
+	bool interrupted();
+	std::string stopReply() const;
+	std::string resume(bool step);
+	std::string readRegisters() const;
+	bool writeRegister(int number, const std::string &hex);
+	std::string handle(const std::string &packet, bool &detach);
+
+public:
+	explicit GdbStub(Debugger &debugger);
+	~GdbStub();
+	GdbStub(const GdbStub &) = delete;
+	GdbStub &operator=(const GdbStub &) = delete;
+
+	// listens on 127.0.0.1:port, 0 for any free port, false if it can't
+	bool listen(int port);
+	int port() const;
+
+	// waits for a client and serves it until it detaches, kills the session
+	// or disconnects, with the CPU halted until it asks to continue
+	void serve();
+};
+
+#endif /* GDBSTUB_H */
@@ -0,0 +1,31 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "common.hpp"
+#include "nescontroller.hpp"
+
+// Controller 1 input recorded a frame per line in FCEUX's "RLDUTSBA"
+// notation. Returns nothing if the file can't be read. Runs longer than the
+// log see every button released once it runs out, see inputForFrame.
+inline std::vector<byte> readInputLog(const std::string &path)
+{
+	std::vector<byte> inputs;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		inputs.push_back(NESController::parseButtons(line));
+	}
+	return inputs;
+}
+
+// what a log holds for frame, nothing pressed past its end
+inline byte inputForFrame(const std::vector<byte> &inputs, long frame)
+{
+	return static_cast<size_t>(frame) < inputs.size() ? inputs[frame] : 0;
+}
+
+#endif /* INPUTLOG_H */
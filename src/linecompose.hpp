@@ -0,0 +1,125 @@
+#ifndef LINECOMPOSE_H
+#define LINECOMPOSE_H
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "common.hpp"
+
+// Scanline compositing for the batched PPU renderer. A sprite line holds one
+// byte per pixel, the colour within the sprite palettes in bits 0-3 (0 is
+// transparent) along with the priority and sprite 0 flags. A background line
+// holds the 2-bit pixel with the attribute palette in bits 2-3.
+
+constexpr byte lineSpriteBehind = 0x20;
+constexpr byte lineSpriteZero = 0x40;
+
+// Sprites are merged in OAM order, so each one only fills pixels no earlier
+// sprite has made opaque. line must have room for 8 pixels at x.
+inline void mergeSpriteRowScalar(byte *line, const byte *row)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		if (!line[i])
+		{
+			line[i] = row[i];
+		}
+	}
+}
+
+// Picks the palette index of each pixel and returns the first x where sprite
+// 0 overlaps opaque background, or -1. count is a multiple of 16.
+inline int composeLineScalar(const byte *background, const byte *sprites, byte *indices, int count)
+{
+	int sprite0Hit = -1;
+	for (int x = 0; x < count; ++x)
+	{
+		const bool backgroundOpaque = background[x] & 0x03;
+		const byte sprite = sprites[x];
+		if ((sprite & lineSpriteZero) && backgroundOpaque && sprite0Hit < 0)
+		{
+			sprite0Hit = x;
+		}
+		if ((sprite & 0x0f) && (!(sprite & lineSpriteBehind) || !backgroundOpaque))
+		{
+			indices[x] = 0x10 | (sprite & 0x0f);
+		}
+		else
+		{
+			indices[x] = backgroundOpaque ? background[x] : 0;
+		}
+	}
+	return sprite0Hit;
+}
+
+#ifdef __SSE2__
+inline void mergeSpriteRowSSE2(byte *line, const byte *row)
+{
+	const __m128i existing = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(line));
+	const __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row));
+	const __m128i empty = _mm_cmpeq_epi8(existing, _mm_setzero_si128());
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(line), _mm_or_si128(existing, _mm_and_si128(empty, pixels)));
+}
+
+// 16 pixels at a time, every selection is a mask so there are no branches
+// until the sprite 0 hit mask is checked
+inline int composeLineSSE2(const byte *background, const byte *sprites, byte *indices, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i pixelBits = _mm_set1_epi8(0x03);
+	const __m128i colourBits = _mm_set1_epi8(0x0f);
+	const __m128i spritePalettes = _mm_set1_epi8(0x10);
+	const __m128i behindBit = _mm_set1_epi8(lineSpriteBehind);
+	const __m128i zeroBit = _mm_set1_epi8(lineSpriteZero);
+
+	int sprite0Hit = -1;
+	for (int x = 0; x < count; x += 16)
+	{
+		const __m128i tiles = _mm_loadu_si128(reinterpret_cast<const __m128i *>(background + x));
+		const __m128i line = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sprites + x));
+
+		const __m128i backgroundClear = _mm_cmpeq_epi8(_mm_and_si128(tiles, pixelBits), zero);
+		const __m128i colour = _mm_and_si128(line, colourBits);
+		const __m128i spriteClear = _mm_cmpeq_epi8(colour, zero);
+		const __m128i inFront = _mm_cmpeq_epi8(_mm_and_si128(line, behindBit), zero);
+		const __m128i spriteShown = _mm_andnot_si128(spriteClear, _mm_or_si128(inFront, backgroundClear));
+
+		const __m128i spriteIndex = _mm_or_si128(colour, spritePalettes);
+		const __m128i backgroundIndex = _mm_andnot_si128(backgroundClear, tiles);
+		const __m128i result = _mm_or_si128(_mm_and_si128(spriteShown, spriteIndex),
+											_mm_andnot_si128(spriteShown, backgroundIndex));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(indices + x), result);
+
+		if (sprite0Hit < 0)
+		{
+			const __m128i sprite0 = _mm_cmpeq_epi8(_mm_and_si128(line, zeroBit), zeroBit);
+			const int hits = _mm_movemask_epi8(_mm_andnot_si128(backgroundClear, sprite0));
+			if (hits)
+			{
+				sprite0Hit = x + __builtin_ctz(hits);
+			}
+		}
+	}
+	return sprite0Hit;
+}
+#endif
+
+inline void mergeSpriteRow(byte *line, const byte *row)
+{
+#ifdef __SSE2__
+	mergeSpriteRowSSE2(line, row);
+#else
+	mergeSpriteRowScalar(line, row);
+#endif
+}
+
+inline int composeLine(const byte *background, const byte *sprites, byte *indices, int count)
+{
+#ifdef __SSE2__
+	return composeLineSSE2(background, sprites, indices, count);
+#else
+	return composeLineScalar(background, sprites, indices, count);
+#endif
+}
+
+#endif /* LINECOMPOSE_H */
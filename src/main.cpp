@@ -2,10 +2,103 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <SDL.h>
 
+#include "framebuffer.hpp"
+#include "framepacer.hpp"
+#include "movie.hpp"
+#include "movieplayer.hpp"
 #include "nes.hpp"
 #include "nescart.hpp"
+#include "nespalette.hpp"
+#include "ringbuffer.hpp"
+#include "triplebuffer.hpp"
+
+using FrameExchange = TripleBuffer<FrameBuffer>;
+using AudioRing = RingBuffer<int16_t, 16384>;
+
+// samples kept queued ahead of the audio device, the emulation thread waits
+// while the ring holds more than this
+constexpr size_t audioLatency = static_cast<size_t>(NESAPU::sampleRate / 20);
+
+static void audioCallback(void *userdata, Uint8 *stream, int length)
+{
+	AudioRing &ring = *static_cast<AudioRing *>(userdata);
+	int16_t *samples = reinterpret_cast<int16_t *>(stream);
+	const size_t count = length / sizeof(int16_t);
+	const size_t popped = ring.pop(samples, count);
+	std::fill(samples + popped, samples + count, popped > 0 ? samples[popped - 1] : 0);
+}
+
+// arrows, X and Z for A and B, Enter for Start and right Shift for Select
+static byte keyboardButtons()
+{
+	const Uint8 *keys = SDL_GetKeyboardState(nullptr);
+	return (keys[SDL_SCANCODE_X] ? NESController::A : 0)
+		| (keys[SDL_SCANCODE_Z] ? NESController::B : 0)
+		| (keys[SDL_SCANCODE_RSHIFT] ? NESController::Select : 0)
+		| (keys[SDL_SCANCODE_RETURN] ? NESController::Start : 0)
+		| (keys[SDL_SCANCODE_UP] ? NESController::Up : 0)
+		| (keys[SDL_SCANCODE_DOWN] ? NESController::Down : 0)
+		| (keys[SDL_SCANCODE_LEFT] ? NESController::Left : 0)
+		| (keys[SDL_SCANCODE_RIGHT] ? NESController::Right : 0);
+}
+
+// input is taken once a frame, from the keyboard or a movie being played, so
+// a recording holds exactly what each frame saw. A movie's resets are
+// handled as nesebar_replay handles them, see movieplayer.hpp.
+static void emulate(std::unique_ptr<NES> &nes, const NESCart &cart, FrameExchange &frames, AudioRing &audio,
+					bool audioPacing, double frameRate, const std::atomic<byte> &keyboard, const Movie *playback,
+					Movie *recording, const std::atomic<bool> &keepRunning)
+{
+	FramePacer pacer(frameRate);
+	std::array<int16_t, 2048> samples;
+	size_t frame = 0;
+	bool halted = false;
+	bool warnedReset = false;
+	while (keepRunning.load(std::memory_order_relaxed))
+	{
+		Movie::Frame input = {0, {keyboard.load(std::memory_order_relaxed), 0}};
+		if (playback && frame < playback->frames.size())
+		{
+			input = playback->frames[frame];
+		}
+		startMovieFrame(nes, cart, input, frame, warnedReset);
+		halted = halted && !(input.commands & Movie::HardReset);
+		if (recording)
+		{
+			recording->frames.push_back(input);
+		}
+		++frame;
+
+		if (!nes->runFrame(frames.writeBuffer()) && !halted)
+		{
+			std::cerr << "The CPU halted at $" << std::hex << nes->cpuState().pc.value << std::dec << std::endl;
+			halted = true;
+		}
+		frames.publish();
+
+		const int count = nes->readAudio(samples.data(), samples.size());
+		audio.push(samples.data(), count);
+		if (audioPacing)
+		{
+			while (audio.size() > audioLatency && keepRunning.load(std::memory_order_relaxed))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		else
+		{
+			pacer.wait();
+		}
+	}
+}
 
 int main(int argc, const char *argv[])
 {
@@ -14,20 +107,85 @@ int main(int argc, const char *argv[])
 		std::string path(argv[1]);
 		std::cout << "ROM File: " << path << std::endl;
 
-		SDL_Init(SDL_INIT_VIDEO);
+		SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
 		SDL_Window *window = SDL_CreateWindow("Nesebar", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-											  256, 240, 0);
-		SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, 0);
-
+											  screenWidth, screenHeight, 0);
 		if (!window)
 		{
 			exit(1);
 		}
 
+		// vsync only throttles presentation, emulation is paced by the audio
+		// ring, or FramePacer if there's no audio device
+		SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+		SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+												 SDL_TEXTUREACCESS_STREAMING,
+												 screenWidth, screenHeight);
+
 		NESCart cart(path);
-		NES nes(cart, renderer);
+		std::unique_ptr<Movie> playback, recording;
+		std::string recordPath;
+		bool syncSaves = false;
+		for (int i = 2; i < argc; ++i)
+		{
+			const std::string arg(argv[i]);
+			if (arg == "--sync-saves")
+			{
+				syncSaves = true;
+			}
+			else if (arg == "--play" && i + 1 < argc)
+			{
+				playback = std::make_unique<Movie>();
+				if (!playback->read(argv[++i]))
+				{
+					exit(1);
+				}
+			}
+			else if (arg == "--record" && i + 1 < argc)
+			{
+				recordPath = argv[++i];
+				recording = std::make_unique<Movie>();
+				recording->romFilename = std::filesystem::path(path).filename().string();
+				recording->pal = cart.timing == Timing::PAL;
+			}
+		}
+
+		// movies start from power on with no save, the way they're replayed
+		const bool movie = playback || recording;
+		const std::string savePath = movie ? std::string() : std::filesystem::path(path).replace_extension(".sav").string();
+		auto nes = std::make_unique<NES>(cart, savePath);
+		if (syncSaves)
+		{
+			nes->setSaveSync(SaveSync::Async);
+		}
+		auto frames = std::make_unique<FrameExchange>();
+		auto audio = std::make_unique<AudioRing>();
+
+		SDL_AudioSpec desired = {};
+		desired.freq = static_cast<int>(NESAPU::sampleRate);
+		desired.format = AUDIO_S16SYS;
+		desired.channels = 1;
+		desired.samples = 512;
+		desired.callback = audioCallback;
+		desired.userdata = audio.get();
+		SDL_AudioSpec obtained;
+		const SDL_AudioDeviceID audioDevice = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+		if (!audioDevice)
+		{
+			std::cerr << "Can't open audio device: " << SDL_GetError() << std::endl;
+		}
+
+		std::atomic<bool> keepRunning(true);
+		std::atomic<byte> keyboard(0);
+		const bool pal = cart.timing == Timing::PAL || cart.timing == Timing::Dendy;
+		std::thread emulation(emulate, std::ref(nes), std::cref(cart), std::ref(*frames), std::ref(*audio),
+							  audioDevice != 0, pal ? palFrameRate : ntscFrameRate, std::cref(keyboard),
+							  playback.get(), recording.get(), std::cref(keepRunning));
+		if (audioDevice)
+		{
+			SDL_PauseAudioDevice(audioDevice, 0);
+		}
 
-		bool keepRunning = true;
 		while (keepRunning)
 		{
 			SDL_Event event;
@@ -45,10 +203,38 @@ int main(int argc, const char *argv[])
 					}
 				}
 			}
+			keyboard.store(keyboardButtons(), std::memory_order_relaxed);
+
+			if (frames->consume())
+			{
+				// palette indices are converted to RGB here, off the emulation thread
+				void *pixels;
+				int pitch;
+				if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) == 0)
+				{
+					frameToARGB(frames->readBuffer(), static_cast<uint32_t *>(pixels), pitch / sizeof(uint32_t));
+					SDL_UnlockTexture(texture);
+				}
+				SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+				SDL_RenderPresent(renderer);
+			}
+			else
+			{
+				SDL_Delay(1);
+			}
+		}
 
-			nes.run();
+		emulation.join();
+		if (recording)
+		{
+			recording->write(recordPath);
+		}
+		if (audioDevice)
+		{
+			SDL_CloseAudioDevice(audioDevice);
 		}
 
+		SDL_DestroyTexture(texture);
 		SDL_DestroyRenderer(renderer);
 		SDL_DestroyWindow(window);
 		SDL_Quit();
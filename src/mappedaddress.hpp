@@ -6,17 +6,20 @@
 struct MappedAddress
 {
 	MemAddress address;
-	bool readOnly;
+	bool rom; // address is an offset into PRG-ROM rather than RAM
+	bool io; // access is handled by the mapping's read/write, not CPU memory
 
 	MappedAddress()
 	{
 		address = 0;
-		readOnly = false;
+		rom = false;
+		io = false;
 	}
-	MappedAddress(const MemAddress &address, bool readOnly = false)
+	MappedAddress(const MemAddress &address, bool rom = false, bool io = false)
 	{
 		this->address = address;
-		this->readOnly = readOnly;
+		this->rom = rom;
+		this->io = io;
 	}
 };
 
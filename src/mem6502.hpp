@@ -3,11 +3,11 @@
 
 #include <iostream>
 #include <iomanip>
+#include "breakpoints.hpp"
 #include "common.hpp"
 #include "memaddress.hpp"
-#include "memchunk.hpp"
-#include "mappedaddress.hpp"
 #include "state.hpp"
+#include "trace.hpp"
 
 namespace mos6502
 {
@@ -23,49 +23,58 @@ namespace mos6502
 		}
 	};
 
-	template<typename Mapping>
+	// The 6502's addressing modes on top of a bus, see bus.hpp
+	template<typename Bus>
 	class Mem6502
 	{
-		static constexpr unsigned int cpuMemSize = 65535;
-		
 		State &cpuState;
-		MemChunk<byte, cpuMemSize> memory;
-		const Mapping &mapping;
+		Bus &bus;
+		Breakpoints *breakpoints;
 
 	public:
-		Mem6502(State &cpuState, const Mapping &mapping) : cpuState(cpuState), mapping(mapping)
+		Mem6502(State &cpuState, Bus &bus) : cpuState(cpuState), bus(bus), breakpoints(nullptr)
 		{
 		}
 
+		// checked on every access when built with NESEBAR_DEBUGGER, null
+		// for none
+		void setBreakpoints(Breakpoints *breakpoints) { this->breakpoints = breakpoints; }
+		Breakpoints *getBreakpoints() const { return breakpoints; }
+
 		byte read(const MemAddress &address)
 		{
-			const byte result = memory[mapping.mapAddress(address).address];
-			return result;
+			if constexpr (debuggerEnabled)
+			{
+				if (breakpoints)
+				{
+					breakpoints->access(Breakpoints::Read, address);
+				}
+			}
+			return bus.read(address);
 		}
 
 		void write(const MemAddress &address, byte value)
 		{
-			MappedAddress mapped = mapping.mapAddress(address);
-			if (!mapped.readOnly)
+			if constexpr (debuggerEnabled)
 			{
-				memory[mapped.address] = value;
-			}
-			else
-			{
-				exit(EXIT_FAILURE);
+				if (breakpoints)
+				{
+					breakpoints->access(Breakpoints::Write, address);
+				}
 			}
+			bus.write(address, value);
 		}
 
-		MemAddress readMemAddress(const MemAddress &address)
+		byte peek(const MemAddress &address) const
 		{
-			return MemAddress(read(address), read(address + 1));
+			return bus.peek(address);
 		}
-		
-		byte &operator[](const MemAddress &address)
+
+		MemAddress readMemAddress(const MemAddress &address)
 		{
-			return memory[address];
+			return MemAddress(read(address), read(address + 1));
 		}
-		
+
 		// Memory access
 		byte fetchByte()
 		{
@@ -84,7 +93,7 @@ namespace mos6502
 		byte memRelative()
 		{
 			byte data = fetchByte();
-			std::cout << std::hex << " #$" << static_cast<int>(data)
+			trace << std::hex << " #$" << static_cast<int>(data)
 					  << " ($" << (cpuState.pc + data).value << ") ";
 			return data;
 		}
@@ -92,7 +101,7 @@ namespace mos6502
 		byte fetchImmediate()
 		{
 			byte data = fetchByte();
-			std::cout << " #" << std::hex << std::setw(2)
+			trace << " #" << std::hex << std::setw(2)
 					<< static_cast<int>(data);
 			return data;
 		}
@@ -104,14 +113,14 @@ namespace mos6502
 		MemAddress addressAbsolute()
 		{
 			MemAddress addr = fetchNextMemAddress();
-			std::cout << " $" << std::hex << std::setw(4) << static_cast<uint16_t>(addr.value);
+			trace << " $" << std::hex << std::setw(4) << static_cast<uint16_t>(addr.value);
 			return addr;
 		}
 		MemAccess fetchAbsolute()
 		{
 			MemAddress addr = fetchNextMemAddress();
 			byte data = read(addr);
-			std::cout << " $" << std::hex << std::setw(4) << static_cast<uint16_t>(addr.value)
+			trace << " $" << std::hex << std::setw(4) << static_cast<uint16_t>(addr.value)
 				<< " = " << std::setw(2) << static_cast<int>(data);
 			return MemAccess(addr, data);
 		}
@@ -145,7 +154,7 @@ namespace mos6502
 			if (addr.add(cpuState.y)) ++cpuState.pageCrossCycles;
 			const byte data = read(addr);
 
-			std::cout << " $" << std::hex << std::setw(2) << addr.value
+			trace << " $" << std::hex << std::setw(2) << addr.value
 					  << " = " << static_cast<int>(data);
 			return MemAccess(addr, data);
 		}
@@ -159,13 +168,13 @@ namespace mos6502
 		{
 			byte addr = fetchByte();
 			byte data = read(addr);
-			std::cout << " $" << std::hex << std::setw(2) << static_cast<int>(addr)
+			trace << " $" << std::hex << std::setw(2) << static_cast<int>(addr)
 					<< " = " << static_cast<int>(data);
 			return MemAccess(addr, data);
 		}
 		void writeZeroPage(MemAddress address, byte value)
 		{
-			std::cout << " $" << std::setw(2) << std::hex << address.value
+			trace << " $" << std::setw(2) << std::hex << address.value
 					<< " = " << static_cast<int>(value);
 
 			write(address, value);
@@ -179,7 +188,7 @@ namespace mos6502
 		{
 			MemAddress address = addressZeroPageIndexed(index);
 			byte data = read(address);
-			std::cout << " $" << std::hex << std::setw(2) << static_cast<int>(address.value)
+			trace << " $" << std::hex << std::setw(2) << static_cast<int>(address.value)
 					  << " = " << static_cast<int>(data);
 			return MemAccess(address, data);
 		}
@@ -202,29 +211,30 @@ namespace mos6502
 			write(address, value);
 		}
 
-		// indexed addressing
-		MemAccess addressIndexedIndirect()
+		// indexed addressing, the address apart from the access so that
+		// stores never read what they write to
+		MemAddress addressIndexedIndirect()
 		{
 			byte zeroPageAddr = (fetchByte() + cpuState.x) % 256;
-			std::cout << " @ " << std::setw(2) << std::hex << static_cast<int>(zeroPageAddr);
+			trace << " @ " << std::setw(2) << std::hex << static_cast<int>(zeroPageAddr);
 			MemAddress indirect(read(zeroPageAddr), read((zeroPageAddr + 1) % 256));
 
-			std::cout << " " << std::setw(4) << std::hex << static_cast<int>(indirect.value);
-			byte value = read(indirect); // TODO: This read is pointless, only for debug
-
-			std::cout << " = " << std::setw(2) << std::hex << static_cast<int>(value);
-			return MemAccess(indirect, value);
+			trace << " " << std::setw(4) << std::hex << static_cast<int>(indirect.value);
+			return indirect;
 		}
 		MemAccess fetchIndexedIndirect()
 		{
-			return addressIndexedIndirect();
+			const MemAddress address = addressIndexedIndirect();
+			const byte value = read(address);
+			trace << " = " << std::setw(2) << std::hex << static_cast<int>(value);
+			return MemAccess(address, value);
 		}
 		void writeIndexedIndirect(byte value)
 		{
-			write(addressIndexedIndirect().address, value);
+			write(addressIndexedIndirect(), value);
 		}
 
-		MemAccess addressIndirectIndexed()
+		MemAddress addressIndirectIndexed()
 		{
 			// get the zero page address
 			const byte zeroPage = fetchByte();
@@ -236,21 +246,21 @@ namespace mos6502
 			MemAddress effective = indirect;
 			if (effective.add(cpuState.y)) ++cpuState.pageCrossCycles;
 
-			std::cout << std::hex << " ($" << std::setw(2) << static_cast<int>(zeroPage) << "), Y = "
+			trace << std::hex << " ($" << std::setw(2) << static_cast<int>(zeroPage) << "), Y = "
 					  << std::setw(4) << indirect.value
 					  << " @ " << std::setw(4) << std::hex << effective.value;
-			byte value = read(effective); // TODO: This read is pointless, only for debug
-			std::cout << " = " << std::setw(2) << std::hex << static_cast<int>(value);
-
-			return MemAccess(effective, value);
+			return effective;
 		}
 		MemAccess fetchIndirectIndexed()
 		{
-			return addressIndirectIndexed();
+			const MemAddress address = addressIndirectIndexed();
+			const byte value = read(address);
+			trace << " = " << std::setw(2) << std::hex << static_cast<int>(value);
+			return MemAccess(address, value);
 		}
 		void writeIndirectIndexed(byte value)
 		{
-			write(addressIndirectIndexed().address, value);
+			write(addressIndirectIndexed(), value);
 		}
 	};
 }
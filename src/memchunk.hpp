@@ -8,7 +8,7 @@
 template <typename T, unsigned int N>
 class MemChunk
 {
-	std::array<T, N> memory;
+	std::array<T, N> memory{};
 
 public:
 	T &operator[](const MemAddress &address)
@@ -20,6 +20,11 @@ public:
 	{
 		return memory;
 	}
+
+	const auto &data() const
+	{
+		return memory;
+	}
 };
 
 
@@ -0,0 +1,141 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "common.hpp"
+#include "nescontroller.hpp"
+
+// Controller input for a run, a frame at a time, in FCEUX's text FM2 format:
+// "key value" header lines, then a "|commands|port0|port1|port2|" line per
+// frame with each standard controller in "RLDUTSBA" notation. Only the two
+// standard controllers are kept; the header keys that say otherwise, and
+// binary movies, are refused when reading.
+struct Movie
+{
+	enum Command : byte
+	{
+		SoftReset = 0x01,
+		HardReset = 0x02
+	};
+
+	struct Frame
+	{
+		byte commands;
+		std::array<byte, 2> buttons;
+	};
+
+	std::string romFilename;
+	bool pal = false;
+	std::vector<Frame> frames;
+
+	// returns false, saying why on cerr, if path isn't a movie we can play
+	bool read(const std::string &path)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			std::cerr << "Can't open movie " << path << std::endl;
+			return false;
+		}
+		frames.clear();
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+			if (line.empty())
+			{
+				continue;
+			}
+			if (line[0] == '|')
+			{
+				std::vector<std::string> fields;
+				std::istringstream cells(line.substr(1));
+				std::string cell;
+				while (std::getline(cells, cell, '|'))
+				{
+					fields.push_back(cell);
+				}
+				Frame frame = {};
+				if (fields.size() > 0 && !fields[0].empty())
+				{
+					const std::string &cell = fields[0];
+					int commands;
+					const std::from_chars_result parsed = std::from_chars(cell.data(), cell.data() + cell.size(), commands);
+					if (parsed.ec != std::errc() || parsed.ptr != cell.data() + cell.size() || commands < 0
+						|| commands > 0xff)
+					{
+						std::cerr << "Movie " << path << " has commands \"" << cell << "\" on frame " << frames.size()
+								  << ", which aren't a number" << std::endl;
+						return false;
+					}
+					frame.commands = commands;
+				}
+				for (size_t port = 0; port < frame.buttons.size() && port + 1 < fields.size(); ++port)
+				{
+					frame.buttons[port] = NESController::parseButtons(fields[port + 1]);
+				}
+				frames.push_back(frame);
+				continue;
+			}
+
+			const size_t split = line.find(' ');
+			const std::string key = line.substr(0, split);
+			const std::string value = split == std::string::npos ? std::string() : line.substr(split + 1);
+			if (key == "romFilename")
+			{
+				romFilename = value;
+			}
+			else if (key == "palFlag")
+			{
+				pal = value == "1";
+			}
+			else if ((key == "binary" || key == "fourscore" || key == "FDS") && value != "0")
+			{
+				std::cerr << "Movie " << path << " needs " << key << ", which isn't supported" << std::endl;
+				return false;
+			}
+			else if ((key == "port0" || key == "port1") && value != "0" && value != "1")
+			{
+				std::cerr << "Movie " << path << " uses a controller other than the standard one" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool write(const std::string &path) const
+	{
+		std::ofstream file(path);
+		file << "version 3\n"
+			 << "emuVersion 0\n"
+			 << "rerecordCount 0\n"
+			 << "palFlag " << (pal ? 1 : 0) << "\n"
+			 << "romFilename " << romFilename << "\n"
+			 << "fourscore 0\n"
+			 << "port0 1\n"
+			 << "port1 1\n"
+			 << "port2 0\n";
+		for (const Frame &frame : frames)
+		{
+			file << '|' << static_cast<int>(frame.commands) << '|' << NESController::formatButtons(frame.buttons[0])
+				 << '|' << NESController::formatButtons(frame.buttons[1]) << "||\n";
+		}
+		if (!file)
+		{
+			std::cerr << "Can't write movie " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+};
+
+#endif /* MOVIE_H */
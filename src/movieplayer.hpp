@@ -0,0 +1,57 @@
+#ifndef MOVIEPLAYER_H
+#define MOVIEPLAYER_H
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include "fnv1a.hpp"
+#include "framebuffer.hpp"
+#include "movie.hpp"
+#include "nes.hpp"
+#include "nescart.hpp"
+
+// Gets nes ready for a movie frame, the same way in every player: a hard
+// reset powers the machine on again, without a save file, and the frame's
+// buttons are held. Soft resets aren't supported and get a warning on cerr
+// the first time, warnedReset keeping track of that.
+inline void startMovieFrame(std::unique_ptr<NES> &nes, const NESCart &cart, const Movie::Frame &input, long frame,
+							bool &warnedReset)
+{
+	if (input.commands & Movie::HardReset)
+	{
+		nes = std::make_unique<NES>(cart);
+	}
+	else if (input.commands & Movie::SoftReset && !warnedReset)
+	{
+		std::cerr << "Soft resets aren't supported, ignoring them from frame " << frame << std::endl;
+		warnedReset = true;
+	}
+	nes->setButtons(0, input.buttons[0]);
+	nes->setButtons(1, input.buttons[1]);
+}
+
+// Runs the first frames of a movie on a machine powered on for it, with no
+// save file, handing each frame's number, machine and picture to onFrame.
+template <typename OnFrame>
+void playMovie(const NESCart &cart, const Movie &movie, long frames, OnFrame onFrame)
+{
+	auto nes = std::make_unique<NES>(cart);
+	auto frame = std::make_unique<FrameBuffer>();
+	bool warnedReset = false;
+	for (long i = 0; i < frames; ++i)
+	{
+		startMovieFrame(nes, cart, movie.frames[i], i, warnedReset);
+		nes->runFrame(*frame);
+		onFrame(i, *nes, *frame);
+	}
+}
+
+// the frame number and hashes of CPU RAM and the picture, the line
+// nesebar_replay writes for each frame
+inline void writeFrameHashes(std::ostream &out, long frame, const NES &nes, const FrameBuffer &picture)
+{
+	out << std::dec << frame << ' ' << std::hex << std::setfill('0') << std::setw(16) << fnv1a(nes.ram(), NES::ramSize)
+		<< ' ' << std::setw(16) << frameHash(picture) << std::dec << std::setfill(' ') << '\n';
+}
+
+#endif /* MOVIEPLAYER_H */
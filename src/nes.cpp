@@ -1,19 +1,115 @@
 #include "nes.hpp"
 
-NES::NES(const NESCart &cart, SDL_Renderer *renderer) : mapping(cart), cpu(mapping), ppu(renderer)
+NES::NES(const NESCart &cart, const std::string &savePath)
+	: apu(NESAPU::clockRate(cart.timing)), ppu(cart), mapping(cart, ppu, apu, savePath), cpu(mapping)
 {
-	// copy cart ROM into CPU memory directly
-	for (MemAddress addr = 0; addr < cart.prgRom.size(); ++addr)
+	saveSync = SaveSync::None;
+	dotsPerFiveCycles = cart.timing == Timing::PAL ? palDotsPerFiveCycles : ntscDotsPerFiveCycles;
+	dotFifths = 0;
+	instructionsRun = 0;
+
+	// silence the APU and its frame IRQ before the program starts
+	mapping.write(0x4017, 0);
+	mapping.write(0x4015, 0);
+	for (MemAddress addr = 0x4000; addr <= 0x4013; ++addr)
 	{
-		Memory &memory = cpu.getMemory();
-		const MemAddress romStart = 0x8000;
-		memory[addr + romStart] = cart.prgRom[addr.value];
+		mapping.write(addr, 0);
 	}
 	cpu.reset();
+	cyclesRun = cpu.getState().totalCycles;
+}
+
+NES::NES(const NES &other)
+	: apu(other.apu), ppu(other.ppu), mapping(other.mapping, ppu, apu), cpu(other.cpu, mapping),
+	  cyclesRun(other.cyclesRun), instructionsRun(other.instructionsRun),
+	  dotsPerFiveCycles(other.dotsPerFiveCycles), dotFifths(other.dotFifths), saveSync(other.saveSync)
+{
+}
+
+std::unique_ptr<NES> NES::fork() const
+{
+	return std::unique_ptr<NES>(new NES(*this));
+}
+
+bool NES::run()
+{
+	if (!cpu.step())
+	{
+		return false;
+	}
+	++instructionsRun;
+
+	const long totalCycles = cpu.getState().totalCycles;
+	const int cycles = totalCycles - cyclesRun;
+	cyclesRun = totalCycles;
+	apu.run(cycles);
+	dotFifths += cycles * dotsPerFiveCycles;
+	ppu.run(dotFifths / 5);
+	dotFifths %= 5;
+
+	byte dmaPage;
+	if (mapping.takeDMA(dmaPage))
+	{
+		if (const byte *page = mapping.pageData(dmaPage))
+		{
+			ppu.writeOAMPage(page);
+		}
+		else
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				ppu.writeOAM(mapping.read(MemAddress(i, dmaPage)));
+			}
+		}
+		// the DMA waits an extra cycle to start on an even one
+		cpu.stall(oamDMACycles + (cpu.getState().totalCycles & 1));
+	}
+	if (apu.dmcRequest())
+	{
+		apu.dmcFill(mapping.read(apu.dmcAddress()));
+		cpu.stall(dmcFetchCycles);
+	}
+	if (ppu.nmi())
+	{
+		cpu.nmi();
+	}
+	if (apu.irqPending())
+	{
+		cpu.irq();
+	}
+	return true;
 }
 
-void NES::run()
+void NES::finishFrame()
 {
-	cpu.step();
-	ppu.run();
+	apu.endFrame();
+	mapping.syncSave(saveSync);
+}
+
+bool NES::runFrame(FrameBuffer &frame)
+{
+	ppu.setFrame(&frame);
+	bool complete;
+	while (!(complete = ppu.endOfFrame()) && run())
+	{
+	}
+	ppu.setFrame(nullptr);
+	if (complete)
+	{
+		finishFrame();
+	}
+	return complete;
+}
+
+bool NES::step(FrameBuffer &frame)
+{
+	ppu.setFrame(&frame);
+	run();
+	ppu.setFrame(nullptr);
+	const bool complete = ppu.endOfFrame();
+	if (complete)
+	{
+		finishFrame();
+	}
+	return complete;
 }
@@ -1,22 +1,94 @@
 #ifndef NES_H
 #define NES_H
 
+#include <memory>
 #include "core6502.hpp"
-#include "mem6502.hpp"
+#include "framebuffer.hpp"
+#include "nesapu.hpp"
 #include "nesmemory.hpp"
 #include "nesppu.hpp"
 
 class NES
 {
-	using Memory = mos6502::Mem6502<NESMemory>;
+	// PAL runs 3.2 PPU dots per CPU cycle, so dots are counted in fifths
+	static constexpr int ntscDotsPerFiveCycles = 15;
+	static constexpr int palDotsPerFiveCycles = 16;
+	static constexpr int dmcFetchCycles = 4;
+	static constexpr int oamDMACycles = 513;
 
-	const NESMemory mapping;
-	mos6502::Core<Memory, NESMemory, false> cpu;
+	NESAPU apu;
 	NESPPU ppu;
+	NESMemory mapping;
+	mos6502::Core<NESMemory, false> cpu;
+	long cyclesRun;
+	long instructionsRun;
+	int dotsPerFiveCycles, dotFifths;
+	SaveSync saveSync;
+
+	NES(const NES &other);
+	void finishFrame();
 
 public:
-	NES(const NESCart &cart, SDL_Renderer *renderer);
-	void run();
+	static constexpr size_t ramSize = 0x800;
+
+	// battery backed RAM is kept in savePath when the cart has any
+	NES(const NESCart &cart, const std::string &savePath = std::string());
+	NES &operator=(const NES &) = delete;
+
+	// a machine in exactly this one's state that goes its own way from here.
+	// ROM is shared, and RAM, VRAM and CHR-RAM are shared copy on write a
+	// page at a time. What gets copied is the chip state, about 2K on the
+	// heap for NROM; the fork rebuilds the PPU's sprite lists and drops the
+	// audio nobody has read yet. The fork has no save file; battery backed
+	// RAM is copied out of it.
+	std::unique_ptr<NES> fork() const;
+
+	// one instruction and what the rest of the machine does meanwhile,
+	// false without running it when the CPU is stopped at a breakpoint or
+	// halted
+	bool run();
+
+	// runs until the PPU finishes frame, returns false if a breakpoint
+	// stopped it first, in which case the next call carries on with it, or
+	// the CPU halted
+	bool runFrame(FrameBuffer &frame);
+
+	// one instruction drawing into frame, for debuggers, returns true when
+	// that finished the frame
+	bool step(FrameBuffer &frame);
+
+	void setBatchedRendering(bool enabled) { ppu.setBatchedRendering(enabled); }
+
+	// how save RAM is flushed to its file at the end of each frame, None by
+	// default since the mapping already survives the emulator exiting
+	void setSaveSync(SaveSync mode) { saveSync = mode; }
+
+	// buttons held on the controller in port 0 or 1, a mask of
+	// NESController::Button, can be called from any thread
+	void setButtons(int port, byte buttons) { mapping.controller(port).setButtons(buttons); }
+
+	// whether the CPU ran into a JAM or an opcode the core doesn't have and
+	// stopped for good; frames run after that finish nothing
+	bool halted() const { return cpu.getState().halted; }
+
+	// instructions the CPU has run since power on
+	long instructionCount() const { return instructionsRun; }
+
+	// the CPU an instruction at a time, run() steps it, for tests and tools
+	const mos6502::State &cpuState() const { return cpu.getState(); }
+	void setCpuState(const mos6502::State &state) { cpu.setState(state); }
+	void jump(const MemAddress &address) { cpu.jump(address); }
+	byte peek(const MemAddress &address) const { return mapping.peek(address); }
+	// a write as the CPU would make it, registers included
+	void poke(const MemAddress &address, byte value) { mapping.write(address, value); }
+	const byte *ram() const { return mapping.ram(); }
+
+	// breakpoints the CPU checks when built with NESEBAR_DEBUGGER, null for
+	// none; see breakpoints.hpp. A fork starts without any.
+	void setBreakpoints(mos6502::Breakpoints *breakpoints) { cpu.setBreakpoints(breakpoints); }
+
+	// audio produced by the frames run so far
+	int readAudio(int16_t *out, int count) { return apu.readSamples(out, count); }
 };
 
 #endif /* NES_H */
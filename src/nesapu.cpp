@@ -0,0 +1,556 @@
+#include "nesapu.hpp"
+
+namespace
+{
+	constexpr byte lengthTable[32] = {
+		10, 254, 20, 2, 40, 4, 80, 6, 160, 8, 60, 10, 14, 12, 26, 14,
+		12, 16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+	};
+	constexpr byte dutyTable[4] = {0b00000010, 0b00000110, 0b00011110, 0b11111001};
+	constexpr byte triangleTable[32] = {
+		15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+	};
+	constexpr uint16_t noisePeriods[16] = {
+		4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
+	};
+	constexpr uint16_t dmcRates[16] = {
+		428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
+	};
+
+	// frame sequencer steps in CPU cycles, NTSC
+	constexpr int fourStepTimes[4] = {7457, 14913, 22371, 29829};
+	constexpr int fiveStepTimes[5] = {7457, 14913, 22371, 29829, 37281};
+	constexpr int fourStepPeriod = 29830;
+	constexpr int fiveStepPeriod = 37282;
+
+	// linear approximation of the NES mixer, scaled to 16-bit output
+	constexpr float pulseWeight = 0.00752f * 32767;
+	constexpr float triangleWeight = 0.00851f * 32767;
+	constexpr float noiseWeight = 0.00494f * 32767;
+	constexpr float dmcWeight = 0.00335f * 32767;
+
+	inline void updateAmplitude(BlipBuffer &blip, float weight, uint32_t time, int &amplitude, int newAmplitude)
+	{
+		if (newAmplitude != amplitude)
+		{
+			blip.addDelta(time, (newAmplitude - amplitude) * weight);
+			amplitude = newAmplitude;
+		}
+	}
+
+	// advances a timer that's producing no audible change
+	inline void skipPeriods(uint32_t &time, uint32_t endTime, int period, int &count)
+	{
+		count = 0;
+		if (time < endTime)
+		{
+			count = (endTime - time + period - 1) / period;
+			time += count * period;
+		}
+	}
+}
+
+// Envelope
+
+void NESAPU::Envelope::write(byte value)
+{
+	loop = value & 0x20;
+	constant = value & 0x10;
+	period = value & 0x0f;
+}
+
+void NESAPU::Envelope::clock()
+{
+	if (start)
+	{
+		start = false;
+		decay = 15;
+		divider = period;
+	}
+	else if (divider == 0)
+	{
+		divider = period;
+		if (decay > 0) --decay;
+		else if (loop) decay = 15;
+	}
+	else
+	{
+		--divider;
+	}
+}
+
+// Pulse
+
+NESAPU::Pulse::Pulse(bool onesComplement) : onesComplement(onesComplement)
+{
+	enabled = false;
+	duty = step = lengthCounter = 0;
+	timerPeriod = 0;
+	sweepEnabled = sweepNegate = sweepReload = false;
+	sweepPeriod = sweepShift = sweepDivider = 0;
+	delay = amplitude = 0;
+}
+
+void NESAPU::Pulse::write(int reg, byte value)
+{
+	switch (reg)
+	{
+		case 0:
+		{
+			duty = value >> 6;
+			envelope.write(value);
+			break;
+		}
+		case 1:
+		{
+			sweepEnabled = value & 0x80;
+			sweepPeriod = (value >> 4) & 0x07;
+			sweepNegate = value & 0x08;
+			sweepShift = value & 0x07;
+			sweepReload = true;
+			break;
+		}
+		case 2:
+		{
+			timerPeriod = (timerPeriod & 0x0700) | value;
+			break;
+		}
+		case 3:
+		{
+			timerPeriod = (timerPeriod & 0x00ff) | ((value & 0x07) << 8);
+			if (enabled) lengthCounter = lengthTable[value >> 3];
+			step = 0;
+			envelope.start = true;
+			break;
+		}
+	}
+}
+
+uint16_t NESAPU::Pulse::sweepTarget() const
+{
+	const uint16_t change = timerPeriod >> sweepShift;
+	if (sweepNegate)
+	{
+		return timerPeriod - change - (onesComplement ? 1 : 0);
+	}
+	return timerPeriod + change;
+}
+
+bool NESAPU::Pulse::muted() const
+{
+	return lengthCounter == 0 || timerPeriod < 8 || (!sweepNegate && sweepTarget() > 0x7ff);
+}
+
+void NESAPU::Pulse::clockSweep()
+{
+	if (sweepDivider == 0 && sweepEnabled && sweepShift > 0 && !muted())
+	{
+		timerPeriod = sweepTarget();
+	}
+	if (sweepDivider == 0 || sweepReload)
+	{
+		sweepDivider = sweepPeriod;
+		sweepReload = false;
+	}
+	else
+	{
+		--sweepDivider;
+	}
+}
+
+void NESAPU::Pulse::run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime)
+{
+	const int volume = muted() ? 0 : envelope.volume();
+	const int period = (timerPeriod + 1) * 2;
+	updateAmplitude(blip, weight, time, amplitude, (dutyTable[duty] >> step & 1) ? volume : 0);
+
+	time += delay;
+	if (volume == 0)
+	{
+		int count;
+		skipPeriods(time, endTime, period, count);
+		step = (step + count) & 7;
+	}
+	else
+	{
+		while (time < endTime)
+		{
+			step = (step + 1) & 7;
+			updateAmplitude(blip, weight, time, amplitude, (dutyTable[duty] >> step & 1) ? volume : 0);
+			time += period;
+		}
+	}
+	delay = time - endTime;
+}
+
+// Triangle
+
+NESAPU::Triangle::Triangle()
+{
+	enabled = control = linearReload = false;
+	step = lengthCounter = linearCounter = linearPeriod = 0;
+	timerPeriod = 0;
+	delay = amplitude = 0;
+}
+
+void NESAPU::Triangle::write(int reg, byte value)
+{
+	switch (reg)
+	{
+		case 0:
+		{
+			control = value & 0x80;
+			linearPeriod = value & 0x7f;
+			break;
+		}
+		case 2:
+		{
+			timerPeriod = (timerPeriod & 0x0700) | value;
+			break;
+		}
+		case 3:
+		{
+			timerPeriod = (timerPeriod & 0x00ff) | ((value & 0x07) << 8);
+			if (enabled) lengthCounter = lengthTable[value >> 3];
+			linearReload = true;
+			break;
+		}
+	}
+}
+
+void NESAPU::Triangle::clockLinear()
+{
+	if (linearReload) linearCounter = linearPeriod;
+	else if (linearCounter > 0) --linearCounter;
+
+	if (!control) linearReload = false;
+}
+
+void NESAPU::Triangle::run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime)
+{
+	const int period = timerPeriod + 1;
+	updateAmplitude(blip, weight, time, amplitude, triangleTable[step]);
+
+	time += delay;
+	// the sequencer halts when silenced; ultrasonic periods are held too since
+	// they'd only produce aliasing
+	if (lengthCounter == 0 || linearCounter == 0 || timerPeriod < 2)
+	{
+		int count;
+		skipPeriods(time, endTime, period, count);
+	}
+	else
+	{
+		while (time < endTime)
+		{
+			step = (step + 1) & 31;
+			updateAmplitude(blip, weight, time, amplitude, triangleTable[step]);
+			time += period;
+		}
+	}
+	delay = time - endTime;
+}
+
+// Noise
+
+NESAPU::Noise::Noise()
+{
+	enabled = mode = false;
+	periodIndex = lengthCounter = 0;
+	shifter = 1;
+	delay = amplitude = 0;
+}
+
+void NESAPU::Noise::write(int reg, byte value)
+{
+	switch (reg)
+	{
+		case 0:
+		{
+			envelope.write(value);
+			break;
+		}
+		case 2:
+		{
+			mode = value & 0x80;
+			periodIndex = value & 0x0f;
+			break;
+		}
+		case 3:
+		{
+			if (enabled) lengthCounter = lengthTable[value >> 3];
+			envelope.start = true;
+			break;
+		}
+	}
+}
+
+void NESAPU::Noise::run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime)
+{
+	const int volume = lengthCounter == 0 ? 0 : envelope.volume();
+	const int period = noisePeriods[periodIndex];
+	const int tap = mode ? 6 : 1;
+	updateAmplitude(blip, weight, time, amplitude, (shifter & 1) ? 0 : volume);
+
+	// the shifter keeps running while silent so the sequence stays deterministic
+	for (time += delay; time < endTime; time += period)
+	{
+		const uint16_t feedback = (shifter ^ (shifter >> tap)) & 1;
+		shifter = (shifter >> 1) | (feedback << 14);
+		updateAmplitude(blip, weight, time, amplitude, (shifter & 1) ? 0 : volume);
+	}
+	delay = time - endTime;
+}
+
+// DMC
+
+NESAPU::DMC::DMC()
+{
+	irqEnabled = loop = irqFlag = false;
+	rateIndex = level = 0;
+	sampleAddress = currentAddress = 0xc000;
+	sampleLength = 1;
+	bytesRemaining = 0;
+	sampleBuffer = shifter = 0;
+	bitsRemaining = 8;
+	bufferEmpty = silence = true;
+	delay = amplitude = 0;
+}
+
+void NESAPU::DMC::write(int reg, byte value)
+{
+	switch (reg)
+	{
+		case 0:
+		{
+			irqEnabled = value & 0x80;
+			loop = value & 0x40;
+			rateIndex = value & 0x0f;
+			if (!irqEnabled) irqFlag = false;
+			break;
+		}
+		case 1:
+		{
+			level = value & 0x7f;
+			break;
+		}
+		case 2:
+		{
+			sampleAddress = 0xc000 + value * 64;
+			break;
+		}
+		case 3:
+		{
+			sampleLength = value * 16 + 1;
+			break;
+		}
+	}
+}
+
+void NESAPU::DMC::restart()
+{
+	currentAddress = sampleAddress;
+	bytesRemaining = sampleLength;
+}
+
+void NESAPU::DMC::fill(byte value)
+{
+	sampleBuffer = value;
+	bufferEmpty = false;
+	currentAddress = currentAddress == 0xffff ? 0x8000 : currentAddress + 1;
+	if (--bytesRemaining == 0)
+	{
+		if (loop) restart();
+		else if (irqEnabled) irqFlag = true;
+	}
+}
+
+void NESAPU::DMC::run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime)
+{
+	const int period = dmcRates[rateIndex];
+	updateAmplitude(blip, weight, time, amplitude, level);
+
+	for (time += delay; time < endTime; time += period)
+	{
+		if (!silence)
+		{
+			if (shifter & 1)
+			{
+				if (level <= 125) level += 2;
+			}
+			else if (level >= 2)
+			{
+				level -= 2;
+			}
+			shifter >>= 1;
+			updateAmplitude(blip, weight, time, amplitude, level);
+		}
+
+		if (--bitsRemaining == 0)
+		{
+			bitsRemaining = 8;
+			silence = bufferEmpty;
+			if (!bufferEmpty)
+			{
+				shifter = sampleBuffer;
+				bufferEmpty = true;
+			}
+		}
+	}
+	delay = time - endTime;
+}
+
+// APU
+
+NESAPU::NESAPU(double clockRate) : blip(clockRate, sampleRate, bufferSamples), pulse1(true), pulse2(false)
+{
+	time = 0;
+	frameCycle = frameStep = 0;
+	fiveStepMode = irqInhibit = frameIRQ = false;
+}
+
+void NESAPU::writeRegister(const MemAddress &address, byte value)
+{
+	const int reg = address.value & 0x03;
+	if (address < 0x4004)
+	{
+		pulse1.write(reg, value);
+	}
+	else if (address < 0x4008)
+	{
+		pulse2.write(reg, value);
+	}
+	else if (address < 0x400c)
+	{
+		triangle.write(reg, value);
+	}
+	else if (address < 0x4010)
+	{
+		noise.write(reg, value);
+	}
+	else if (address < 0x4014)
+	{
+		dmc.write(reg, value);
+	}
+	else if (address == 0x4015)
+	{
+		pulse1.enabled = value & 0x01;
+		pulse2.enabled = value & 0x02;
+		triangle.enabled = value & 0x04;
+		noise.enabled = value & 0x08;
+		if (!pulse1.enabled) pulse1.lengthCounter = 0;
+		if (!pulse2.enabled) pulse2.lengthCounter = 0;
+		if (!triangle.enabled) triangle.lengthCounter = 0;
+		if (!noise.enabled) noise.lengthCounter = 0;
+
+		if (!(value & 0x10)) dmc.bytesRemaining = 0;
+		else if (dmc.bytesRemaining == 0) dmc.restart();
+		dmc.irqFlag = false;
+	}
+	else if (address == 0x4017)
+	{
+		fiveStepMode = value & 0x80;
+		irqInhibit = value & 0x40;
+		if (irqInhibit) frameIRQ = false;
+
+		frameCycle = frameStep = 0;
+		if (fiveStepMode)
+		{
+			clockQuarterFrame();
+			clockHalfFrame();
+		}
+	}
+}
+
+byte NESAPU::readStatus()
+{
+	byte status = 0;
+	if (pulse1.lengthCounter > 0) status |= 0x01;
+	if (pulse2.lengthCounter > 0) status |= 0x02;
+	if (triangle.lengthCounter > 0) status |= 0x04;
+	if (noise.lengthCounter > 0) status |= 0x08;
+	if (dmc.bytesRemaining > 0) status |= 0x10;
+	if (frameIRQ) status |= 0x40;
+	if (dmc.irqFlag) status |= 0x80;
+	frameIRQ = false;
+	return status;
+}
+
+void NESAPU::runChannels(uint32_t endTime)
+{
+	pulse1.run(blip, pulseWeight, time, endTime);
+	pulse2.run(blip, pulseWeight, time, endTime);
+	triangle.run(blip, triangleWeight, time, endTime);
+	noise.run(blip, noiseWeight, time, endTime);
+	dmc.run(blip, dmcWeight, time, endTime);
+	time = endTime;
+}
+
+void NESAPU::clockQuarterFrame()
+{
+	pulse1.envelope.clock();
+	pulse2.envelope.clock();
+	noise.envelope.clock();
+	triangle.clockLinear();
+}
+
+void NESAPU::clockHalfFrame()
+{
+	if (pulse1.lengthCounter > 0 && !pulse1.envelope.loop) --pulse1.lengthCounter;
+	if (pulse2.lengthCounter > 0 && !pulse2.envelope.loop) --pulse2.lengthCounter;
+	if (triangle.lengthCounter > 0 && !triangle.control) --triangle.lengthCounter;
+	if (noise.lengthCounter > 0 && !noise.envelope.loop) --noise.lengthCounter;
+	pulse1.clockSweep();
+	pulse2.clockSweep();
+}
+
+void NESAPU::clockFrameStep()
+{
+	if (fiveStepMode)
+	{
+		if (frameStep != 3) clockQuarterFrame();
+		if (frameStep == 1 || frameStep == 4) clockHalfFrame();
+	}
+	else
+	{
+		clockQuarterFrame();
+		if (frameStep == 1 || frameStep == 3) clockHalfFrame();
+		if (frameStep == 3 && !irqInhibit) frameIRQ = true;
+	}
+}
+
+void NESAPU::run(int cycles)
+{
+	const int *stepTimes = fiveStepMode ? fiveStepTimes : fourStepTimes;
+	const int stepCount = fiveStepMode ? 5 : 4;
+
+	// run the channels up to each frame sequencer step, then clock it
+	int untilStep = stepTimes[frameStep] - frameCycle;
+	while (untilStep <= cycles)
+	{
+		runChannels(time + untilStep);
+		frameCycle += untilStep;
+		cycles -= untilStep;
+		clockFrameStep();
+		if (++frameStep == stepCount)
+		{
+			frameStep = 0;
+			frameCycle -= fiveStepMode ? fiveStepPeriod : fourStepPeriod;
+		}
+		untilStep = stepTimes[frameStep] - frameCycle;
+	}
+	runChannels(time + cycles);
+	frameCycle += cycles;
+
+	if (time > maxFrameCycles)
+	{
+		endFrame();
+	}
+}
+
+void NESAPU::endFrame()
+{
+	blip.endFrame(time);
+	time = 0;
+}
@@ -0,0 +1,140 @@
+#ifndef NESAPU_H
+#define NESAPU_H
+
+#include <cstdint>
+#include "blipbuffer.hpp"
+#include "common.hpp"
+#include "memaddress.hpp"
+#include "nescart.hpp"
+
+class NESAPU
+{
+public:
+	static constexpr double cpuClockRate = 1789773.0;
+	static constexpr double palClockRate = 1662607.0;
+	static constexpr double dendyClockRate = 1773448.0;
+	static constexpr double sampleRate = 48000.0;
+
+	static double clockRate(Timing timing)
+	{
+		return timing == Timing::PAL ? palClockRate : timing == Timing::Dendy ? dendyClockRate : cpuClockRate;
+	}
+
+private:
+	static constexpr int bufferSamples = 4096;
+	static constexpr uint32_t maxFrameCycles = 32768; // longest audio frame before it's ended internally
+
+	struct Envelope
+	{
+		bool start, loop, constant;
+		byte period, divider, decay;
+
+		Envelope() : start(false), loop(false), constant(false), period(0), divider(0), decay(0) {}
+
+		void write(byte value);
+		void clock();
+		int volume() const { return constant ? period : decay; }
+	};
+
+	struct Pulse
+	{
+		Envelope envelope;
+		const bool onesComplement; // pulse 1 negates the sweep with one's complement
+		bool enabled;
+		byte duty, step, lengthCounter;
+		uint16_t timerPeriod;
+		bool sweepEnabled, sweepNegate, sweepReload;
+		byte sweepPeriod, sweepShift, sweepDivider;
+		int delay, amplitude;
+
+		Pulse(bool onesComplement);
+
+		void write(int reg, byte value);
+		uint16_t sweepTarget() const;
+		bool muted() const;
+		void clockSweep();
+		void run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime);
+	};
+
+	struct Triangle
+	{
+		bool enabled, control, linearReload;
+		byte step, lengthCounter, linearCounter, linearPeriod;
+		uint16_t timerPeriod;
+		int delay, amplitude;
+
+		Triangle();
+
+		void write(int reg, byte value);
+		void clockLinear();
+		void run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime);
+	};
+
+	struct Noise
+	{
+		Envelope envelope;
+		bool enabled, mode;
+		byte periodIndex, lengthCounter;
+		uint16_t shifter;
+		int delay, amplitude;
+
+		Noise();
+
+		void write(int reg, byte value);
+		void run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime);
+	};
+
+	struct DMC
+	{
+		bool irqEnabled, loop, irqFlag;
+		byte rateIndex, level;
+		uint16_t sampleAddress, sampleLength, currentAddress, bytesRemaining;
+		byte sampleBuffer, shifter, bitsRemaining;
+		bool bufferEmpty, silence;
+		int delay, amplitude;
+
+		DMC();
+
+		void write(int reg, byte value);
+		void restart();
+		void fill(byte value);
+		void run(BlipBuffer &blip, float weight, uint32_t time, uint32_t endTime);
+	};
+
+	BlipBuffer blip;
+	Pulse pulse1, pulse2;
+	Triangle triangle;
+	Noise noise;
+	DMC dmc;
+
+	uint32_t time; // CPU cycles into the current audio frame
+	int frameCycle, frameStep;
+	bool fiveStepMode, irqInhibit, frameIRQ;
+
+	void runChannels(uint32_t endTime);
+	void clockQuarterFrame();
+	void clockHalfFrame();
+	void clockFrameStep();
+
+public:
+	NESAPU(double clockRate = cpuClockRate);
+
+	void writeRegister(const MemAddress &address, byte value);
+	byte readStatus();
+
+	// advance by CPU cycles
+	void run(int cycles);
+	void endFrame();
+
+	bool irqPending() const { return frameIRQ || dmc.irqFlag; }
+
+	// DMC sample fetches are serviced by the owner of CPU memory
+	bool dmcRequest() const { return dmc.bufferEmpty && dmc.bytesRemaining > 0; }
+	MemAddress dmcAddress() const { return dmc.currentAddress; }
+	void dmcFill(byte value) { dmc.fill(value); }
+
+	int samplesAvailable() const { return blip.samplesAvailable(); }
+	int readSamples(int16_t *out, int count) { return blip.readSamples(out, count); }
+};
+
+#endif /* NESAPU_H */
@@ -5,60 +5,208 @@
 #include <bitset>
 #include <memory>
 
+#include "crc32.hpp"
 #include "nescart.hpp"
+#include "romarchive.hpp"
+#include "romdb.hpp"
+
+// NES 2.0 ROM sizes are either a page count with its upper bits in byte 9,
+// or when those bits are all set, an exponent and multiplier
+static size_t romSize(byte lsb, byte msb, size_t pageSize)
+{
+	if (msb == 0x0f)
+	{
+		const int exponent = lsb >> 2;
+		const int multiplier = (lsb & 0x03) * 2 + 1;
+		return exponent < 32 ? (size_t(1) << exponent) * multiplier : 0;
+	}
+	return ((msb << 8) | lsb) * pageSize;
+}
+
+// NES 2.0 RAM sizes are shift counts, 0 meaning none
+static size_t ramSize(byte shift)
+{
+	return shift ? size_t(64) << shift : 0;
+}
 
 NESCart::NESCart(const std::string &romPath)
 {
-	std::ifstream romFile(romPath, std::ios::in | std::ios::binary);
-	if (romFile.is_open())
+	// compressed ROMs are inflated as they're read, straight into prgRom and
+	// chrRom
+	switch (detectRomFormat(romPath))
 	{
-		// load iNES header
-		romFile.read((char *)&header, sizeof(Header));
-		if (header.code[0] == 'N' && header.code[1] == 'E' &&
-			header.code[2] == 'S' && header.code[3] == 0x1A)
+		case RomFormat::Gzip:
 		{
-			std::cout << "iNES OK" << std::endl;
+			GzipStreamBuf gzip(romPath);
+			if (gzip.isOpen())
+			{
+				std::istream romFile(&gzip);
+				load(romFile);
+				return;
+			}
+			break;
 		}
-		else
+		case RomFormat::Zip:
 		{
-			std::cout << "iNES Error" << std::endl;
+			ZipStreamBuf zip(romPath);
+			if (zip.isOpen())
+			{
+				std::istream romFile(&zip);
+				load(romFile);
+				return;
+			}
+			break;
 		}
-
-		// read flags
-		std::bitset<8> flag6(header.flag6);
-		std::bitset<8> flag7(header.flag7);
-
-		// reader mapper #
-		byte flag6bits = static_cast<byte>(flag6.to_ulong());
-		byte flag7bits = static_cast<byte>(flag7.to_ulong());
-		byte mapperNum = ((flag6bits >> 4) & 0b00001111)
-			| (flag7bits & 0b11110000);
-		std::cout << "Read Mapper #" << std::setw(2)
-				  << std::setfill('0') << (int)mapperNum << std::endl;
-
-		// check flag6 for trainer, read if needed
-		bool hasTrainer = flag6.test(flag6Trainer);
-		if (hasTrainer)
+		case RomFormat::Plain:
 		{
-			// throw away for now
-			byte trainer[trainerSize];
-			romFile.read((char *)trainer, trainerSize);
+			std::ifstream romFile(romPath, std::ios::in | std::ios::binary);
+			if (romFile.is_open())
+			{
+				load(romFile);
+				romFile.close();
+				return;
+			}
+			break;
 		}
+	}
+	std::cerr << "Can't load ROM file." << std::endl;
+}
 
-		const size_t prgRomBytes = prgRomPageSize * header.prgRomSize;
-		const size_t chrRomBytes = chrRomPageSize * header.chrRomSize;
-		prgRom.resize(prgRomBytes);
-		chrRom.resize(chrRomBytes);
-		std::cout << "PRG ROM Size: " << prgRomBytes << " bytes\n"
-				  << "CHR ROM Size: " << chrRomBytes << " bytes" << std::endl;
+NESCart::NESCart(std::istream &romFile)
+{
+	load(romFile);
+}
 
-		romFile.read((char *)&prgRom[0], prgRomBytes);
-		romFile.read((char *)&chrRom[0], chrRomBytes);
+void NESCart::load(std::istream &romFile)
+{
+	// load iNES header
+	romFile.read((char *)&header, sizeof(Header));
+	if (header.code[0] == 'N' && header.code[1] == 'E' &&
+		header.code[2] == 'S' && header.code[3] == 0x1A)
+	{
+		std::cout << "iNES OK" << std::endl;
+	}
+	else
+	{
+		std::cout << "iNES Error" << std::endl;
+	}
+
+	// read flags
+	std::bitset<8> flag6(header.flag6);
+	nes2 = (header.flag7 & 0x0c) == 0x08;
 
-		romFile.close();
+	// bytes 8-15 hold the NES 2.0 fields, iNES 1.0 only defines the PRG-RAM
+	// size and TV system, and old dumping tools left text in the padding that
+	// can't be trusted as the upper mapper bits
+	const bool padded = header.zeroFilled[1] == 0 && header.zeroFilled[2] == 0 &&
+		header.zeroFilled[3] == 0 && header.zeroFilled[4] == 0;
+	mapper = header.flag6 >> 4;
+	if (nes2 || padded)
+	{
+		mapper |= header.flag7 & 0xf0;
+	}
+
+	size_t prgRomBytes, chrRomBytes;
+	if (nes2)
+	{
+		mapper |= (header.prgRamSize & 0x0f) << 8;
+		submapper = header.prgRamSize >> 4;
+		prgRomBytes = romSize(header.prgRomSize, header.flag9 & 0x0f, prgRomPageSize);
+		chrRomBytes = romSize(header.chrRomSize, header.flag9 >> 4, chrRomPageSize);
+		prgRamBytes = ramSize(header.flag10 & 0x0f);
+		prgNvramBytes = ramSize(header.flag10 >> 4);
+		chrRamBytes = ramSize(header.zeroFilled[0] & 0x0f);
+		chrNvramBytes = ramSize(header.zeroFilled[0] >> 4);
+		timing = static_cast<Timing>(header.zeroFilled[1] & 0x03);
 	}
 	else
 	{
-		std::cerr << "Can't load ROM file." << std::endl;
+		prgRomBytes = prgRomPageSize * header.prgRomSize;
+		chrRomBytes = chrRomPageSize * header.chrRomSize;
+
+		// a PRG-RAM size of 0 means 8K, it's battery backed if flag6 says so
+		const size_t prgRam = prgRamPageSize * (header.prgRamSize ? header.prgRamSize : 1);
+		(flag6.test(flag6SRAMBattery) ? prgNvramBytes : prgRamBytes) = prgRam;
+		chrRamBytes = chrRomBytes ? 0 : chrRomPageSize;
+		timing = (header.flag9 & 0x01) ? Timing::PAL : Timing::NTSC;
 	}
+
+	std::cout << "Read Mapper #" << std::setw(2)
+			  << std::setfill('0') << mapper << std::setfill(' ');
+	if (nes2)
+	{
+		std::cout << "." << submapper << " (NES 2.0)";
+	}
+	std::cout << std::endl;
+
+	// check flag6 for trainer, read if needed
+	bool hasTrainer = flag6.test(flag6Trainer);
+	if (hasTrainer)
+	{
+		// throw away for now
+		byte trainer[trainerSize];
+		romFile.read((char *)trainer, trainerSize);
+	}
+
+	prgRom.resize(prgRomBytes);
+	chrRom.resize(chrRomBytes);
+	std::cout << "PRG ROM Size: " << prgRomBytes << " bytes\n"
+			  << "CHR ROM Size: " << chrRomBytes << " bytes\n"
+			  << "PRG RAM Size: " << prgRamBytes << " + " << prgNvramBytes << " battery bytes\n"
+			  << "CHR RAM Size: " << chrRamBytes << " + " << chrNvramBytes << " battery bytes" << std::endl;
+
+	romFile.read((char *)prgRom.data(), prgRomBytes);
+	romFile.read((char *)chrRom.data(), chrRomBytes);
+
+	crc = calculateCRC32(prgRom.data(), prgRom.size());
+	crc = calculateCRC32(chrRom.data(), chrRom.size(), crc);
+	std::cout << "CRC32: " << std::hex << std::setw(8) << std::setfill('0') << crc
+			  << std::dec << std::setfill(' ') << std::endl;
+
+	// NES 2.0 headers are trusted, the database only fixes up iNES 1.0 ones
+	const RomDbEntry *entry = findRom(crc);
+	if (entry && !nes2)
+	{
+		applyRomDatabase(*entry);
+	}
+}
+
+void NESCart::applyRomDatabase(const RomDbEntry &entry)
+{
+	mapper = entry.mapper;
+	submapper = entry.submapper;
+	timing = entry.timing;
+
+	const byte mirroringBits = (1 << flag6Mirroring) | (1 << flag6FourScreenMode);
+	switch (entry.mirroring)
+	{
+		case RomMirroring::Horizontal:
+		{
+			header.flag6 &= ~mirroringBits;
+			break;
+		}
+		case RomMirroring::Vertical:
+		{
+			header.flag6 = (header.flag6 & ~mirroringBits) | (1 << flag6Mirroring);
+			break;
+		}
+		case RomMirroring::FourScreen:
+		{
+			header.flag6 = (header.flag6 & ~mirroringBits) | (1 << flag6FourScreenMode);
+			break;
+		}
+		case RomMirroring::Header:
+		{
+			break;
+		}
+	}
+
+	// the PRG-RAM the header declared moves between battery backed and not
+	const size_t prgRam = prgRamBytes + prgNvramBytes;
+	prgRamBytes = entry.battery ? 0 : prgRam;
+	prgNvramBytes = entry.battery ? prgRam : 0;
+	header.flag6 = (header.flag6 & ~(1 << flag6SRAMBattery)) | (entry.battery ? 1 << flag6SRAMBattery : 0);
+
+	std::cout << "ROM database: mapper " << mapper << "." << submapper
+			  << (entry.battery ? ", battery" : "") << std::endl;
 }
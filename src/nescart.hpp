@@ -1,6 +1,8 @@
 #ifndef NESCART_H
 #define NESCART_H
 
+#include <istream>
+#include <string>
 #include <vector>
 #include "common.hpp"
 
@@ -11,6 +13,26 @@ constexpr int flag6FourScreenMode = 3;
 constexpr int flag6Trainer = 2;
 constexpr int flag6SRAMBattery = 1;
 constexpr int flag6Mirroring = 0;
+constexpr int prgRamPageSize = 8192;
+
+struct RomDbEntry;
+
+enum class Timing
+{
+	NTSC,
+	PAL,
+	MultiRegion,
+	Dendy
+};
+
+enum class Mirroring
+{
+	Horizontal,
+	Vertical,
+	SingleScreenLower,
+	SingleScreenUpper,
+	FourScreen
+};
 
 struct NESCart
 {
@@ -37,10 +59,34 @@ struct NESCart
 	};
 
 	Header header;
+	bool nes2 = false; // header is NES 2.0 rather than iNES 1.0
+	int mapper = 0, submapper = 0;
+	size_t prgRamBytes = 0, prgNvramBytes = 0; // NVRAM is battery backed
+	size_t chrRamBytes = 0, chrNvramBytes = 0;
+	Timing timing = Timing::NTSC;
+	uint32_t crc = 0; // CRC-32 of PRG-ROM then CHR-ROM
 	std::vector<byte> prgRom;
 	std::vector<byte> chrRom;
 
 	NESCart(const std::string &romPath);
+	NESCart(std::istream &romFile);
+
+	// nametable arrangement wired on the board, mappers can change it later
+	Mirroring mirroring() const
+	{
+		if (header.flag6 & (1 << flag6FourScreenMode))
+		{
+			return Mirroring::FourScreen;
+		}
+		return (header.flag6 & (1 << flag6Mirroring)) ? Mirroring::Vertical : Mirroring::Horizontal;
+	}
+
+	// header corrections from a ROM database entry, done on load for dumps
+	// found in data/romdb.txt
+	void applyRomDatabase(const RomDbEntry &entry);
+
+private:
+	void load(std::istream &romFile);
 };
 
 
@@ -0,0 +1,94 @@
+#ifndef NESCONTROLLER_H
+#define NESCONTROLLER_H
+
+#include <atomic>
+#include <string>
+#include "common.hpp"
+
+// A standard controller, read a button at a time from $4016 or $4017 after
+// a strobe through $4016. The pressed buttons can be set from any thread.
+class NESController
+{
+	static constexpr byte openBus = 0x40;
+
+	std::atomic<byte> buttons;
+	byte shift;
+	bool strobe;
+
+public:
+	enum Button : byte
+	{
+		A = 0x01,
+		B = 0x02,
+		Select = 0x04,
+		Start = 0x08,
+		Up = 0x10,
+		Down = 0x20,
+		Left = 0x40,
+		Right = 0x80
+	};
+
+	NESController() : buttons(0), shift(0), strobe(false) {}
+
+	NESController(const NESController &other)
+		: buttons(other.buttons.load(std::memory_order_relaxed)), shift(other.shift), strobe(other.strobe)
+	{
+	}
+
+	// buttons from FCEUX's "RLDUTSBA" notation, where any character other
+	// than a space or '.' holds the button in that position
+	static byte parseButtons(const std::string &text)
+	{
+		byte pressed = 0;
+		for (size_t i = 0; i < 8 && i < text.size(); ++i)
+		{
+			if (text[i] != ' ' && text[i] != '.')
+			{
+				pressed |= 0x80 >> i;
+			}
+		}
+		return pressed;
+	}
+
+	// the other way, with '.' for buttons not held
+	static std::string formatButtons(byte pressed)
+	{
+		std::string text = "RLDUTSBA";
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (!(pressed & (0x80 >> i)))
+			{
+				text[i] = '.';
+			}
+		}
+		return text;
+	}
+
+	void setButtons(byte pressed)
+	{
+		buttons.store(pressed, std::memory_order_relaxed);
+	}
+
+	void write(byte value)
+	{
+		strobe = value & 1;
+		if (strobe)
+		{
+			shift = buttons.load(std::memory_order_relaxed);
+		}
+	}
+
+	// A first, then B, Select, Start, Up, Down, Left and Right, then 1s
+	byte read()
+	{
+		if (strobe)
+		{
+			return openBus | (buttons.load(std::memory_order_relaxed) & A);
+		}
+		const byte bit = shift & 1;
+		shift = (shift >> 1) | 0x80;
+		return openBus | bit;
+	}
+};
+
+#endif /* NESCONTROLLER_H */
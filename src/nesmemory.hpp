@@ -1,63 +1,265 @@
 #ifndef NESMEMORY_H
 #define NESMEMORY_H
 
-#include "memchunk.hpp"
+#include <array>
+#include <string>
+#include "cowmemory.hpp"
 #include "mappedaddress.hpp"
+#include "nesapu.hpp"
 #include "nescart.hpp"
+#include "nescontroller.hpp"
+#include "nesppu.hpp"
+#include "savefile.hpp"
 
+// The NES CPU bus, see bus.hpp
 class NESMemory
 {
+	static constexpr unsigned int ramSize = 0x800;
+	// the size of RAM, so ram() is one page
+	static constexpr unsigned int pageSize = ramSize;
+	static constexpr unsigned int prgRomStart = 0x8000;
 	static constexpr unsigned int ppuRegistersSize = 8;
 	static constexpr unsigned int ppuSize = 8184;
 	static constexpr unsigned int apuIORegistersSize = 24;
 
 	const NESCart &cart;
+	NESPPU &ppu;
+	NESAPU &apu;
+	bool dmaPending;
+	byte dmaPage;
+	std::array<NESController, 2> controllers;
 
-public:
-	NESMemory(const NESCart &cart) : cart(cart) {}
+	// cart PRG-RAM at $6000-$7FFF, mirrored when it's smaller than 8K. If
+	// it's battery backed and there's a save file, the RAM is the file and
+	// prgRam points at it, otherwise it's prgRamStorage.
+	CowMemory<pageSize> prgRamStorage;
+	SaveFile saveFile;
+	byte *prgRam;
+	size_t prgRamSize;
+	bool saveDirty;
+
+	// the console's RAM, PRG-ROM is read from the cart
+	CowMemory<pageSize> memory;
 
+	// Anything that isn't RAM or PRG-ROM is I/O at its own address, which
+	// covers the registers, PRG-RAM and whatever nothing on the board
+	// answers: that reads as 0 rather than open bus and drops writes.
 	MappedAddress mapAddress(const MemAddress &address) const
 	{
-		MappedAddress mapped;
+		MappedAddress mapped(address, false, true);
 		if (address < 0x2000)
 		{
-			mapped = address % 0x800;
+			mapped = address % ramSize;
 		}
 		else if (address < 0x4000)
 		{
 			// PPU registers
-			mapped = address % 0x8 + 0x2000;
+			mapped = {address % 0x8 + 0x2000, false, true};
+		}
+		else if (address >= prgRomStart)
+		{
+			// PRG-ROM, without a mapper only the first 32K of it can be seen
+			if (cart.prgRom.size() == 0x4000)
+			{
+				mapped = {static_cast<uint16_t>((address.value - prgRomStart) % 0x4000), true};
+			}
+			else if (cart.prgRom.size() >= 0x8000)
+			{
+				mapped = {static_cast<uint16_t>(address.value - prgRomStart), true};
+			}
+		}
+		return mapped;
+	}
+
+	bool isPrgRam(const MemAddress &address) const
+	{
+		return address >= 0x6000 && address < prgRomStart && prgRamSize;
+	}
+
+	byte readMemory(const MappedAddress &mapped) const
+	{
+		return mapped.rom ? cart.prgRom[mapped.address.value] : memory[mapped.address.value];
+	}
+
+	byte readPrgRam(const MemAddress &address) const
+	{
+		const size_t offset = (address.value - 0x6000) % prgRamSize;
+		return prgRam ? prgRam[offset] : prgRamStorage[offset];
+	}
+
+	// memory mapped I/O
+	byte readIO(const MemAddress &address)
+	{
+		if (address < 0x4000)
+		{
+			return ppu.readRegister(address);
+		}
+		else if (address == 0x4015)
+		{
+			return apu.readStatus();
+		}
+		else if (address == 0x4016 || address == 0x4017)
+		{
+			return controllers[address.value - 0x4016].read();
+		}
+		else if (isPrgRam(address))
+		{
+			return readPrgRam(address);
+		}
+		return 0;
+	}
+
+	void writeIO(const MemAddress &address, byte value)
+	{
+		if (address < 0x4000)
+		{
+			ppu.writeRegister(address, value);
 		}
-		else if (address < 0x4020)
+		else if (address == 0x4014)
 		{
-			// APU registers
+			// OAM DMA is carried out by whoever steps the CPU, see takeDMA
+			dmaPending = true;
+			dmaPage = value;
 		}
-		else if (address < 0x6000)
+		else if (address == 0x4016)
 		{
-			// cartridge expansion ROM
+			// one strobe for both ports
+			controllers[0].write(value);
+			controllers[1].write(value);
 		}
-		else if (address < 0x8000)
+		else if (address < 0x4014 || address == 0x4015 || address == 0x4017)
 		{
-			// SRAM
+			apu.writeRegister(address, value);
+		}
+		else if (isPrgRam(address))
+		{
+			const size_t offset = (address.value - 0x6000) % prgRamSize;
+			if (prgRam)
+			{
+				prgRam[offset] = value;
+			}
+			else
+			{
+				prgRamStorage.write(offset, value);
+			}
+			saveDirty = true;
+		}
+	}
+
+public:
+	NESMemory(const NESCart &cart, NESPPU &ppu, NESAPU &apu, const std::string &savePath = std::string())
+		: cart(cart), ppu(ppu), apu(apu), dmaPending(false), dmaPage(0), saveDirty(false), memory(ramSize)
+	{
+		// boards with both kinds of PRG-RAM arrange them in mapper specific
+		// ways, without a mapper that does the battery backed part is all
+		// that's mapped
+		if (cart.prgNvramBytes && !savePath.empty() && saveFile.open(savePath, cart.prgNvramBytes))
+		{
+			prgRam = saveFile.data();
+			prgRamSize = saveFile.size();
 		}
 		else
 		{
-			// PRG-ROM
-			switch (cart.prgRom.size())
+			prgRamSize = cart.prgRamBytes + cart.prgNvramBytes;
+			prgRamStorage = CowMemory<pageSize>(prgRamSize);
+			prgRam = nullptr;
+		}
+	}
+
+	// a copy of other for another machine, sharing its memory copy on write.
+	// The copy has no save file, battery backed RAM is copied out of it.
+	NESMemory(const NESMemory &other, NESPPU &ppu, NESAPU &apu)
+		: cart(other.cart), ppu(ppu), apu(apu), dmaPending(other.dmaPending), dmaPage(other.dmaPage),
+		  controllers(other.controllers), prgRamStorage(other.prgRamStorage), prgRam(nullptr),
+		  prgRamSize(other.prgRamSize), saveDirty(false), memory(other.memory)
+	{
+		if (other.prgRam)
+		{
+			prgRamStorage = CowMemory<pageSize>(prgRamSize);
+			for (size_t offset = 0; offset < prgRamSize; ++offset)
 			{
-				case 0x8000:
-				{
-					mapped = {address, true};
-					break;
-				}
-				case 0x4000:
-				{
-					mapped = {address % 0x4000 + 0x8000, true};
-					break;
-				}
+				prgRamStorage.write(offset, other.prgRam[offset]);
 			}
 		}
-		return mapped;
+	}
+
+	NESMemory(const NESMemory &) = delete;
+	NESMemory &operator=(const NESMemory &) = delete;
+
+	byte read(const MemAddress &address)
+	{
+		const MappedAddress mapped = mapAddress(address);
+		if (mapped.io)
+		{
+			return readIO(mapped.address);
+		}
+		return readMemory(mapped);
+	}
+
+	void write(const MemAddress &address, byte value)
+	{
+		const MappedAddress mapped = mapAddress(address);
+		if (mapped.io)
+		{
+			writeIO(mapped.address, value);
+		}
+		else if (!mapped.rom)
+		{
+			memory.write(mapped.address.value, value);
+		}
+	}
+
+	// registers aren't peeked, reading them can change their state
+	byte peek(const MemAddress &address) const
+	{
+		const MappedAddress mapped = mapAddress(address);
+		if (mapped.io)
+		{
+			return isPrgRam(mapped.address) ? readPrgRam(mapped.address) : 0;
+		}
+		return readMemory(mapped);
+	}
+
+	// CPU memory backing a whole 256 byte page, or null when any of it is
+	// I/O and has to be read a byte at a time
+	const byte *pageData(byte page) const
+	{
+		const MappedAddress first = mapAddress(MemAddress(0x00, page));
+		const MappedAddress last = mapAddress(MemAddress(0xff, page));
+		if (first.io || last.io || first.rom != last.rom || last.address.value != first.address.value + 0xff)
+		{
+			return nullptr;
+		}
+		if (first.rom)
+		{
+			return cart.prgRom.data() + first.address.value;
+		}
+		return memory.page(first.address.value / pageSize) + first.address.value % pageSize;
+	}
+
+	NESController &controller(int port) { return controllers[port]; }
+
+	// the 2K of CPU RAM at $0000, mirrored up to $1FFF
+	const byte *ram() const { return memory.page(0); }
+
+	// writes battery backed RAM changed since the last call back to the save
+	// file, as far as mode asks for
+	void syncSave(SaveSync mode)
+	{
+		if (saveDirty)
+		{
+			saveFile.sync(mode);
+			saveDirty = false;
+		}
+	}
+
+	// returns true once for each $4014 write, with the source page
+	bool takeDMA(byte &page)
+	{
+		page = dmaPage;
+		const bool pending = dmaPending;
+		dmaPending = false;
+		return pending;
 	}
 };
 
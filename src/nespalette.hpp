@@ -0,0 +1,71 @@
+#ifndef NESPALETTE_H
+#define NESPALETTE_H
+
+#include <array>
+#include <cstdint>
+#include "framebuffer.hpp"
+
+// 2C02 colours as ARGB, indexed by the 6-bit values stored in palette RAM
+constexpr std::array<uint32_t, 64> nesPalette = {
+	0xff666666, 0xff002a88, 0xff1412a7, 0xff3b00a4, 0xff5c007e, 0xff6e0040, 0xff6c0600, 0xff561d00,
+	0xff333500, 0xff0b4800, 0xff005200, 0xff004f08, 0xff00404d, 0xff000000, 0xff000000, 0xff000000,
+	0xffadadad, 0xff155fd9, 0xff4240ff, 0xff7527fe, 0xffa01acc, 0xffb71e7b, 0xffb53120, 0xff994e00,
+	0xff6b6d00, 0xff388700, 0xff0c9300, 0xff008f32, 0xff007c8d, 0xff000000, 0xff000000, 0xff000000,
+	0xfffffeff, 0xff64b0ff, 0xff9290ff, 0xffc676ff, 0xfff36aff, 0xfffe6ecc, 0xfffe8170, 0xffea9e22,
+	0xffbcbe00, 0xff88d800, 0xff5ce430, 0xff45e082, 0xff48cdde, 0xff4f4f4f, 0xff000000, 0xff000000,
+	0xfffffeff, 0xffc0dfff, 0xffd3d2ff, 0xffe8c8ff, 0xfffbc2ff, 0xfffec4ea, 0xfffeccc5, 0xfff7d8a5,
+	0xffe4e594, 0xffcfef96, 0xffbdf4ab, 0xffb3f3cc, 0xffb5ebf2, 0xffb8b8b8, 0xff000000, 0xff000000
+};
+
+// nesPalette for each of the 8 combinations of the PPUMASK emphasis bits;
+// each emphasised component dims the other two
+struct EmphasisPalettes
+{
+	std::array<std::array<uint32_t, 64>, 8> colours;
+
+	constexpr EmphasisPalettes() : colours()
+	{
+		constexpr double attenuation = 0.816328;
+		for (int emphasis = 0; emphasis < 8; ++emphasis)
+		{
+			// emphasis bits are red, green, blue from the lowest
+			double scale[3] = {1.0, 1.0, 1.0};
+			for (int component = 0; component < 3; ++component)
+			{
+				if (emphasis & (1 << component))
+				{
+					for (int other = 0; other < 3; ++other)
+					{
+						if (other != component) scale[other] *= attenuation;
+					}
+				}
+			}
+			for (int index = 0; index < 64; ++index)
+			{
+				const uint32_t colour = nesPalette[index];
+				const uint32_t red = static_cast<uint32_t>(((colour >> 16) & 0xff) * scale[0]);
+				const uint32_t green = static_cast<uint32_t>(((colour >> 8) & 0xff) * scale[1]);
+				const uint32_t blue = static_cast<uint32_t>((colour & 0xff) * scale[2]);
+				colours[emphasis][index] = 0xff000000 | (red << 16) | (green << 8) | blue;
+			}
+		}
+	}
+};
+
+constexpr EmphasisPalettes emphasisPalettes;
+
+// converts a frame to ARGB, pitch is in pixels
+inline void frameToARGB(const FrameBuffer &frame, uint32_t *out, int pitch)
+{
+	for (int y = 0; y < screenHeight; ++y, out += pitch)
+	{
+		const std::array<uint32_t, 64> &colours = emphasisPalettes.colours[frame.emphasis[y] & 0x07];
+		const byte *line = &frame.pixels[y * screenWidth];
+		for (int x = 0; x < screenWidth; ++x)
+		{
+			out[x] = colours[line[x] & 0x3f];
+		}
+	}
+}
+
+#endif /* NESPALETTE_H */
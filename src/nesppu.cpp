@@ -0,0 +1,649 @@
+#include <algorithm>
+#include "linecompose.hpp"
+#include "nesppu.hpp"
+
+NESPPU::NESPPU(const NESCart &cart) : vram(0x1000)
+{
+	if (cart.chrRom.empty())
+	{
+		const size_t chrRamBytes = cart.chrRamBytes + cart.chrNvramBytes;
+		patterns.loadRam(chrRamBytes ? chrRamBytes : chrRomPageSize);
+	}
+	else
+	{
+		patterns.load(cart.chrRom.data(), cart.chrRom.size());
+	}
+	setMirroring(cart.mirroring());
+	palette.fill(0);
+	oam.fill(0);
+
+	ctrl = mask = status = oamAddr = 0;
+	v = t = 0;
+	fineX = 0;
+	writeToggle = false;
+	readBuffer = 0;
+
+	switch (cart.timing)
+	{
+		case Timing::PAL:
+		{
+			scanlinesPerFrame = 312;
+			vblankScanline = 241;
+			break;
+		}
+		case Timing::Dendy:
+		{
+			scanlinesPerFrame = 312;
+			vblankScanline = 291;
+			break;
+		}
+		default:
+		{
+			scanlinesPerFrame = 262;
+			vblankScanline = 241;
+			break;
+		}
+	}
+	preRenderScanline = scanlinesPerFrame - 1;
+	skipOddFrameDot = scanlinesPerFrame == 262;
+	dot = scanline = 0;
+	oddFrame = frameComplete = nmiPending = false;
+
+	std::fill(std::begin(backgroundTiles), std::end(backgroundTiles), 0);
+	lineSpriteCount = 0;
+	oamDirty = true;
+	batchedRendering = true;
+	lineBatched = false;
+	sprite0HitDot = 0;
+	frame = nullptr;
+}
+
+void NESPPU::setMirroring(Mirroring mirroring)
+{
+	switch (mirroring)
+	{
+		case Mirroring::Horizontal:
+		{
+			nametables = {0x000, 0x000, 0x400, 0x400};
+			break;
+		}
+		case Mirroring::Vertical:
+		{
+			nametables = {0x000, 0x400, 0x000, 0x400};
+			break;
+		}
+		case Mirroring::SingleScreenLower:
+		{
+			nametables = {0x000, 0x000, 0x000, 0x000};
+			break;
+		}
+		case Mirroring::SingleScreenUpper:
+		{
+			nametables = {0x400, 0x400, 0x400, 0x400};
+			break;
+		}
+		case Mirroring::FourScreen:
+		{
+			nametables = {0x000, 0x400, 0x800, 0xc00};
+			break;
+		}
+	}
+}
+
+uint16_t NESPPU::paletteAddress(uint16_t address) const
+{
+	address &= 0x1f;
+	// sprite palette entry 0 mirrors the background one
+	if ((address & 0x13) == 0x10)
+	{
+		address &= 0x0f;
+	}
+	return address;
+}
+
+byte NESPPU::read(uint16_t address) const
+{
+	address &= 0x3fff;
+	if (address < 0x2000)
+	{
+		return patterns.read(address);
+	}
+	else if (address < 0x3f00)
+	{
+		return vram[nametables[(address >> 10) & 0x03] + (address & 0x03ff)];
+	}
+	return palette[paletteAddress(address)];
+}
+
+void NESPPU::write(uint16_t address, byte value)
+{
+	address &= 0x3fff;
+	if (address < 0x2000)
+	{
+		patterns.write(address, value);
+	}
+	else if (address < 0x3f00)
+	{
+		vram.write(nametables[(address >> 10) & 0x03] + (address & 0x03ff), value);
+	}
+	else
+	{
+		palette[paletteAddress(address)] = value & 0x3f;
+	}
+}
+
+byte NESPPU::readRegister(const MemAddress &address)
+{
+	byte result = 0;
+	switch (address.value & 0x07)
+	{
+		case 2:
+		{
+			result = (status & 0xe0) | (readBuffer & 0x1f);
+			status &= ~statusVBlank;
+			writeToggle = false;
+			break;
+		}
+		case 4:
+		{
+			result = oam[oamAddr];
+			break;
+		}
+		case 7:
+		{
+			leaveBatchedLine();
+			const uint16_t vramAddress = v & 0x3fff;
+			if (vramAddress < 0x3f00)
+			{
+				// reads are delayed by one through the read buffer
+				result = readBuffer;
+				readBuffer = read(vramAddress);
+			}
+			else
+			{
+				result = read(vramAddress);
+				readBuffer = read(vramAddress - 0x1000);
+			}
+			v += (ctrl & ctrlIncrement32) ? 32 : 1;
+			break;
+		}
+	}
+	return result;
+}
+
+void NESPPU::writeRegister(const MemAddress &address, byte value)
+{
+	leaveBatchedLine();
+	switch (address.value & 0x07)
+	{
+		case 0:
+		{
+			// enabling NMI during vblank raises one straight away
+			if (!(ctrl & ctrlNMI) && (value & ctrlNMI) && (status & statusVBlank))
+			{
+				nmiPending = true;
+			}
+			if ((ctrl ^ value) & ctrlSprite8x16)
+			{
+				oamDirty = true;
+			}
+			ctrl = value;
+			t = (t & 0xf3ff) | ((value & 0x03) << 10);
+			break;
+		}
+		case 1:
+		{
+			mask = value;
+			break;
+		}
+		case 3:
+		{
+			oamAddr = value;
+			break;
+		}
+		case 4:
+		{
+			writeOAM(value);
+			break;
+		}
+		case 5:
+		{
+			if (!writeToggle)
+			{
+				t = (t & 0xffe0) | (value >> 3);
+				fineX = value & 0x07;
+			}
+			else
+			{
+				t = (t & 0x8c1f) | ((value & 0xf8) << 2) | ((value & 0x07) << 12);
+			}
+			writeToggle = !writeToggle;
+			break;
+		}
+		case 6:
+		{
+			if (!writeToggle)
+			{
+				t = (t & 0x00ff) | ((value & 0x3f) << 8);
+			}
+			else
+			{
+				t = (t & 0xff00) | value;
+				v = t;
+			}
+			writeToggle = !writeToggle;
+			break;
+		}
+		case 7:
+		{
+			write(v & 0x3fff, value);
+			v += (ctrl & ctrlIncrement32) ? 32 : 1;
+			break;
+		}
+	}
+}
+
+uint16_t NESPPU::nextTile(uint16_t address)
+{
+	if ((address & 0x001f) == 31)
+	{
+		return (address & ~0x001f) ^ 0x0400; // next horizontal nametable
+	}
+	return address + 1;
+}
+
+uint16_t NESPPU::previousTile(uint16_t address)
+{
+	if ((address & 0x001f) == 0)
+	{
+		return (address | 0x001f) ^ 0x0400;
+	}
+	return address - 1;
+}
+
+void NESPPU::incrementX()
+{
+	v = nextTile(v);
+}
+
+void NESPPU::incrementY()
+{
+	if ((v & 0x7000) != 0x7000)
+	{
+		v += 0x1000; // fine Y
+		return;
+	}
+
+	v &= ~0x7000;
+	int coarseY = (v & 0x03e0) >> 5;
+	if (coarseY == 29)
+	{
+		coarseY = 0;
+		v ^= 0x0800; // next vertical nametable
+	}
+	else if (coarseY == 31)
+	{
+		coarseY = 0; // out of bounds rows wrap without switching nametables
+	}
+	else
+	{
+		++coarseY;
+	}
+	v = (v & ~0x03e0) | (coarseY << 5);
+}
+
+void NESPPU::fetchTile(uint16_t address, byte *out)
+{
+	const byte tile = read(0x2000 | (address & 0x0fff));
+	const byte attribute = read(0x23c0 | (address & 0x0c00) | ((address >> 4) & 0x38) | ((address >> 2) & 0x07));
+	const byte attributeShift = ((address >> 4) & 0x04) | (address & 0x02);
+	const byte paletteBits = ((attribute >> attributeShift) & 0x03) << 2;
+	const uint16_t pattern = ((ctrl & ctrlBackgroundTable) ? 0x1000 : 0) + tile * chrTileBytes + ((address >> 12) & 0x07);
+
+	const byte *row = patterns.tileRow(pattern);
+	for (int i = 0; i < 8; ++i)
+	{
+		out[i] = row[i] | paletteBits;
+	}
+}
+
+void NESPPU::fetchBackgroundTile()
+{
+	std::copy(backgroundTiles + 8, backgroundTiles + 16, backgroundTiles);
+	fetchTile(v, backgroundTiles + 8);
+}
+
+void NESPPU::buildSpriteLists()
+{
+	if (!spriteLists.lists)
+	{
+		spriteLists.lists = std::make_unique<SpriteLists>();
+	}
+	SpriteLists &lists = *spriteLists.lists;
+	const int height = (ctrl & ctrlSprite8x16) ? 16 : 8;
+	lists.counts.fill(0);
+	for (int i = 0; i < 64; ++i)
+	{
+		const int top = oam[i * 4];
+		const int bottom = std::min(top + height, screenHeight);
+		for (int line = top; line < bottom; ++line)
+		{
+			if (lists.counts[line] < maxLineSprites)
+			{
+				lists.sprites[line][lists.counts[line]++] = i;
+			}
+		}
+	}
+
+	// Once 8 sprites are found the hardware keeps scanning for the overflow
+	// flag, but steps the byte within each entry along with the entry, so
+	// it compares tile numbers, attributes and X positions as Y coordinates.
+	for (int line = 0; line < screenHeight; ++line)
+	{
+		lists.overflow[line] = false;
+		if (lists.counts[line] < maxLineSprites)
+		{
+			continue;
+		}
+		int entry = lists.sprites[line][maxLineSprites - 1] + 1;
+		int offset = 0;
+		for (; entry < 64; ++entry, offset = (offset + 1) & 0x03)
+		{
+			const int row = line - oam[entry * 4 + offset];
+			if (row >= 0 && row < height)
+			{
+				lists.overflow[line] = true;
+				break;
+			}
+		}
+	}
+	oamDirty = false;
+}
+
+void NESPPU::evaluateSprites(int line)
+{
+	if (oamDirty || !spriteLists.lists)
+	{
+		buildSpriteLists();
+	}
+	const SpriteLists &lists = *spriteLists.lists;
+
+	if (lists.overflow[line])
+	{
+		status |= statusOverflow;
+	}
+
+	const int height = (ctrl & ctrlSprite8x16) ? 16 : 8;
+	lineSpriteCount = 0;
+	for (int slot = 0; slot < lists.counts[line]; ++slot)
+	{
+		const int i = lists.sprites[line][slot];
+		const byte *entry = &oam[i * 4];
+		const int row = line - entry[0];
+
+		const byte tile = entry[1];
+		const byte attributes = entry[2];
+		const int tileRow = (attributes & 0x80) ? height - 1 - row : row;
+		uint16_t pattern;
+		if (height == 16)
+		{
+			pattern = (tile & 0x01) * 0x1000 + (tile & 0xfe) * chrTileBytes
+				+ (tileRow >= 8 ? chrTileBytes : 0) + (tileRow & 0x07);
+		}
+		else
+		{
+			pattern = ((ctrl & ctrlSpriteTable) ? 0x1000 : 0) + tile * chrTileBytes + tileRow;
+		}
+
+		LineSprite &sprite = lineSprites[lineSpriteCount++];
+		sprite.x = entry[3];
+		sprite.behindBackground = attributes & 0x20;
+		sprite.sprite0 = i == 0;
+		const byte *pixels = patterns.tileRow(pattern);
+		const byte paletteBits = (attributes & 0x03) << 2;
+		const bool flipHorizontal = attributes & 0x40;
+		for (int i = 0; i < 8; ++i)
+		{
+			const byte pixel = pixels[flipHorizontal ? 7 - i : i];
+			sprite.pixels[i] = pixel ? pixel | paletteBits : 0;
+		}
+	}
+}
+
+void NESPPU::renderPixel()
+{
+	const int x = dot - 1;
+
+	byte background = 0;
+	if ((mask & maskBackground) && (x >= 8 || (mask & maskBackgroundLeft)))
+	{
+		background = backgroundTiles[(x & 0x07) + fineX];
+	}
+	const bool backgroundOpaque = background & 0x03;
+
+	byte sprite = 0;
+	bool behindBackground = false;
+	if ((mask & maskSprites) && (x >= 8 || (mask & maskSpritesLeft)))
+	{
+		for (int i = 0; i < lineSpriteCount; ++i)
+		{
+			const int offset = x - lineSprites[i].x;
+			if (offset < 0 || offset > 7 || !lineSprites[i].pixels[offset])
+			{
+				continue;
+			}
+			if (lineSprites[i].sprite0 && backgroundOpaque && x != 255)
+			{
+				status |= statusSprite0Hit;
+			}
+			sprite = lineSprites[i].pixels[offset];
+			behindBackground = lineSprites[i].behindBackground;
+			break;
+		}
+	}
+
+	byte colour;
+	if (sprite && (!behindBackground || !backgroundOpaque))
+	{
+		colour = palette[0x10 | sprite];
+	}
+	else if (backgroundOpaque)
+	{
+		colour = palette[background];
+	}
+	else
+	{
+		colour = palette[0];
+	}
+	if (mask & maskGrayscale)
+	{
+		colour &= 0x30;
+	}
+
+	if (frame)
+	{
+		frame->at(x, scanline) = colour;
+	}
+}
+
+void NESPPU::renderLine()
+{
+	// tiles 0 and 1 are already in the pipeline, v points at tile 2 and fine
+	// X can reach into tile 32
+	byte tiles[33 * 8] = {};
+	if (mask & maskBackground)
+	{
+		std::copy(std::begin(backgroundTiles), std::end(backgroundTiles), tiles);
+		uint16_t address = v;
+		for (int tile = 2; tile < 33; ++tile)
+		{
+			fetchTile(address, &tiles[tile * 8]);
+			address = nextTile(address);
+		}
+	}
+
+	byte *background = tiles + fineX;
+	if (!(mask & maskBackgroundLeft))
+	{
+		std::fill(background, background + 8, 0);
+	}
+
+	// sprites can run 8 pixels past the right edge
+	byte sprites[screenWidth + 8] = {};
+	if (mask & maskSprites)
+	{
+		for (int i = 0; i < lineSpriteCount; ++i)
+		{
+			const LineSprite &sprite = lineSprites[i];
+			const byte flags = (sprite.behindBackground ? lineSpriteBehind : 0) | (sprite.sprite0 ? lineSpriteZero : 0);
+			byte row[8];
+			for (int offset = 0; offset < 8; ++offset)
+			{
+				row[offset] = sprite.pixels[offset] ? sprite.pixels[offset] | flags : 0;
+			}
+			mergeSpriteRow(&sprites[sprite.x], row);
+		}
+		if (!(mask & maskSpritesLeft))
+		{
+			std::fill(sprites, sprites + 8, 0);
+		}
+	}
+
+	byte indices[screenWidth];
+	const int sprite0Hit = composeLine(background, sprites, indices, screenWidth);
+	sprite0HitDot = (sprite0Hit >= 0 && sprite0Hit != 255) ? sprite0Hit + 1 : 0;
+
+	if (frame)
+	{
+		byte *out = &frame->at(0, scanline);
+		const byte colourMask = (mask & maskGrayscale) ? 0x30 : 0x3f;
+		for (int x = 0; x < screenWidth; ++x)
+		{
+			out[x] = palette[indices[x]] & colourMask;
+		}
+	}
+}
+
+void NESPPU::leaveBatchedLine()
+{
+	if (!lineBatched)
+	{
+		return;
+	}
+	lineBatched = false;
+	sprite0HitDot = 0;
+	if (renderingEnabled())
+	{
+		// refill the pipeline with the two tiles it would hold by now
+		const uint16_t previous = previousTile(v);
+		fetchTile(previousTile(previous), backgroundTiles);
+		fetchTile(previous, backgroundTiles + 8);
+	}
+}
+
+void NESPPU::tick()
+{
+	const bool visibleLine = scanline < screenHeight;
+	if (visibleLine && dot >= 1 && dot <= 256)
+	{
+		if (dot == 1)
+		{
+			if (frame)
+			{
+				frame->emphasis[scanline] = mask >> 5;
+			}
+			if (batchedRendering)
+			{
+				renderLine();
+				lineBatched = true;
+			}
+		}
+		if (!lineBatched)
+		{
+			renderPixel();
+		}
+		else if (dot == sprite0HitDot)
+		{
+			status |= statusSprite0Hit;
+		}
+	}
+
+	if ((visibleLine || scanline == preRenderScanline) && renderingEnabled())
+	{
+		// tiles are fetched on the last dot of each 8 dot group, including
+		// the first two tiles of the next line at dots 321-336, a batched
+		// line has already used the ones in 1-256
+		if (((dot >= 1 && dot <= 256) || (dot >= 321 && dot <= 336)) && (dot & 0x07) == 0)
+		{
+			if (!lineBatched)
+			{
+				fetchBackgroundTile();
+			}
+			incrementX();
+		}
+		if (dot == 256)
+		{
+			incrementY();
+		}
+		else if (dot == 257)
+		{
+			v = (v & ~0x041f) | (t & 0x041f);
+			if (visibleLine)
+			{
+				evaluateSprites(scanline);
+			}
+			else
+			{
+				lineSpriteCount = 0;
+			}
+		}
+		else if (scanline == preRenderScanline && dot >= 280 && dot <= 304)
+		{
+			v = (v & ~0x7be0) | (t & 0x7be0);
+		}
+	}
+
+	if (dot == 1)
+	{
+		if (scanline == vblankScanline)
+		{
+			status |= statusVBlank;
+			if (ctrl & ctrlNMI)
+			{
+				nmiPending = true;
+			}
+			frameComplete = true;
+		}
+		else if (scanline == preRenderScanline)
+		{
+			status &= ~(statusVBlank | statusSprite0Hit | statusOverflow);
+		}
+	}
+
+	if (dot == 256)
+	{
+		lineBatched = false;
+	}
+
+	// the NTSC pre-render line is a dot shorter on odd frames while rendering
+	++dot;
+	if (dot == dotsPerScanline ||
+		(dot == dotsPerScanline - 1 && scanline == preRenderScanline && oddFrame && skipOddFrameDot &&
+		 renderingEnabled()))
+	{
+		dot = 0;
+		if (++scanline == scanlinesPerFrame)
+		{
+			scanline = 0;
+			oddFrame = !oddFrame;
+		}
+	}
+}
+
+void NESPPU::run(int dots)
+{
+	while (dots-- > 0)
+	{
+		tick();
+	}
+}
@@ -1,27 +1,172 @@
 #ifndef NESPPU_H
 #define NESPPU_H
 
-#include <SDL.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+#include "chrcache.hpp"
+#include "common.hpp"
+#include "cowmemory.hpp"
+#include "framebuffer.hpp"
+#include "memaddress.hpp"
+#include "nescart.hpp"
 
 class NESPPU
 {
-	SDL_Renderer *renderer;
+	static constexpr int dotsPerScanline = 341;
+	static constexpr int maxLineSprites = 8;
+
+	// PPUCTRL
+	static constexpr byte ctrlIncrement32 = 0x04;
+	static constexpr byte ctrlSpriteTable = 0x08;
+	static constexpr byte ctrlBackgroundTable = 0x10;
+	static constexpr byte ctrlSprite8x16 = 0x20;
+	static constexpr byte ctrlNMI = 0x80;
+	// PPUMASK
+	static constexpr byte maskGrayscale = 0x01;
+	static constexpr byte maskBackgroundLeft = 0x02;
+	static constexpr byte maskSpritesLeft = 0x04;
+	static constexpr byte maskBackground = 0x08;
+	static constexpr byte maskSprites = 0x10;
+	// PPUSTATUS
+	static constexpr byte statusOverflow = 0x20;
+	static constexpr byte statusSprite0Hit = 0x40;
+	static constexpr byte statusVBlank = 0x80;
+
+	struct LineSprite
+	{
+		byte x;
+		bool behindBackground, sprite0;
+		byte pixels[8]; // palette index within the sprite palettes, 0 is transparent
+	};
+
+	// pattern tables, either the cart's CHR-ROM or our own CHR-RAM
+	ChrCache patterns;
+	// 2K of nametable RAM in the console plus the 2K four screen carts add,
+	// with the offset of the 1K page behind each of the four nametables
+	CowMemory<0x400> vram;
+	std::array<uint16_t, 4> nametables;
+	std::array<byte, 32> palette;
+	std::array<byte, 256> oam;
+
+	// registers
+	byte ctrl, mask, status, oamAddr;
+	uint16_t v, t; // current and temporary VRAM address
+	byte fineX;
+	bool writeToggle;
+	byte readBuffer;
+
+	// timing, PAL and Dendy frames are 312 lines and never skip a dot
+	int scanlinesPerFrame, vblankScanline, preRenderScanline;
+	bool skipOddFrameDot;
+	int dot, scanline;
+	bool oddFrame, frameComplete, nmiPending;
+
+	// background pipeline, two decoded tiles with the attribute in bits 2-3
+	byte backgroundTiles[16];
+
+	// OAM indices of the first 8 sprites each scanline's evaluation finds
+	// for the line below and whether it sets the overflow flag, rebuilt
+	// whenever OAM or the sprite size changes
+	struct SpriteLists
+	{
+		std::array<std::array<byte, maxLineSprites>, screenHeight> sprites;
+		std::array<byte, screenHeight> counts;
+		std::array<bool, screenHeight> overflow;
+	};
+
+	// the sprite lists only depend on OAM, so a copy of the PPU starts
+	// without them and builds its own when it next needs them
+	struct SpriteListCache
+	{
+		std::unique_ptr<SpriteLists> lists;
+
+		SpriteListCache() = default;
+		SpriteListCache(const SpriteListCache &) {}
+		SpriteListCache &operator=(const SpriteListCache &) = delete;
+	};
+
+	SpriteListCache spriteLists;
+	bool oamDirty;
+
+	// sprites for the current scanline
+	LineSprite lineSprites[maxLineSprites];
+	int lineSpriteCount;
+
+	// Visible lines are rendered whole at dot 1 from the state at the start
+	// of the line, while v still steps through the line dot by dot. A
+	// register access part way through a batched line drops back to
+	// rendering the rest of it a pixel at a time.
+	bool batchedRendering, lineBatched;
+	int sprite0HitDot; // dot the batched line sets sprite 0 hit at, 0 for none
+
+	FrameBuffer *frame;
+
+	bool renderingEnabled() const { return mask & (maskBackground | maskSprites); }
+
+	byte read(uint16_t address) const;
+	void write(uint16_t address, byte value);
+	uint16_t paletteAddress(uint16_t address) const;
+
+	static uint16_t nextTile(uint16_t address);
+	static uint16_t previousTile(uint16_t address);
+	void incrementX();
+	void incrementY();
+	void fetchTile(uint16_t address, byte *out);
+	void fetchBackgroundTile();
+	void buildSpriteLists();
+	void evaluateSprites(int line);
+	void renderPixel();
+	void renderLine();
+	void leaveBatchedLine();
+	void tick();
 
 public:
-	NESPPU(SDL_Renderer *renderer)
+	NESPPU(const NESCart &cart);
+
+	byte readRegister(const MemAddress &address);
+	void writeRegister(const MemAddress &address, byte value);
+	void writeOAM(byte value)
 	{
-		this->renderer = renderer;
+		oam[oamAddr++] = value;
+		oamDirty = true;
 	}
 
-	void run()
+	// a full page of OAM DMA, starting at OAMADDR and wrapping round to it
+	void writeOAMPage(const byte *data)
 	{
-		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-		SDL_RenderClear(renderer);
+		const int split = oam.size() - oamAddr;
+		std::copy(data, data + split, oam.begin() + oamAddr);
+		std::copy(data + split, data + oam.size(), oam.begin());
+		oamDirty = true;
+	}
 
-		SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-		SDL_RenderDrawPoint(renderer, 100, 200);
+	void setMirroring(Mirroring mirroring);
 
-		SDL_RenderPresent(renderer);
+	// frame the PPU renders into, owned by the caller
+	void setFrame(FrameBuffer *frame) { this->frame = frame; }
+
+	// whole line rendering where there are no mid-line register accesses,
+	// on by default
+	void setBatchedRendering(bool enabled) { batchedRendering = enabled; }
+
+	void run(int dots);
+
+	// true once per frame, when the PPU enters vblank
+	bool endOfFrame()
+	{
+		const bool complete = frameComplete;
+		frameComplete = false;
+		return complete;
+	}
+
+	// true once for each NMI the PPU raises
+	bool nmi()
+	{
+		const bool pending = nmiPending;
+		nmiPending = false;
+		return pending;
 	}
 };
 
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "nesvectorenv.hpp"
+
+NESVectorEnv::NESVectorEnv(const NESCart &cart, int count, Observation observation)
+	: cart(cart), observation(observation)
+{
+	if (count <= 0)
+	{
+		throw std::invalid_argument("NESVectorEnv needs at least one instance");
+	}
+	instances.reserve(count);
+	for (int i = 0; i < count; ++i)
+	{
+		instances.push_back(std::make_unique<NES>(cart));
+	}
+	const int frameCount = observation == Observation::Frame ? count : 1;
+	for (int i = 0; i < frameCount; ++i)
+	{
+		frames.push_back(std::make_unique<FrameBuffer>());
+	}
+}
+
+size_t NESVectorEnv::observationSize() const
+{
+	return observation == Observation::Frame ? screenWidth * screenHeight : NES::ramSize;
+}
+
+void NESVectorEnv::reset(int index)
+{
+	instances[index] = std::make_unique<NES>(cart);
+}
+
+void NESVectorEnv::step(const byte *actions, byte *observations)
+{
+	const size_t stride = observationSize();
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		NES &nes = *instances[i];
+		FrameBuffer &frame = *frames[observation == Observation::Frame ? i : 0];
+		nes.setButtons(0, actions[i]);
+		nes.runFrame(frame);
+
+		byte *out = observations + i * stride;
+		if (observation == Observation::Frame)
+		{
+			std::copy(frame.pixels.begin(), frame.pixels.end(), out);
+		}
+		else
+		{
+			std::copy_n(nes.ram(), NES::ramSize, out);
+		}
+	}
+}
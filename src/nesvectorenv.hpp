@@ -0,0 +1,58 @@
+#ifndef NESVECTORENV_H
+#define NESVECTORENV_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "common.hpp"
+#include "framebuffer.hpp"
+#include "nes.hpp"
+#include "nescart.hpp"
+
+// Many copies of one cart stepped together a frame at a time, for training
+// environments. A single step() call runs a frame of each and writes their
+// observations back to back into a buffer the caller owns.
+//
+// step() is a plain loop over runFrame on the calling thread, so it runs no
+// faster than calling runFrame on each NES yourself; what it saves is the
+// bookkeeping. Spreading environments over threads is up to the caller.
+class NESVectorEnv
+{
+public:
+	enum class Observation
+	{
+		Frame, // 256x240 palette indices
+		Ram // the 2K of CPU RAM
+	};
+
+private:
+	const NESCart &cart;
+	Observation observation;
+	std::vector<std::unique_ptr<NES>> instances;
+	// one per instance for Frame, a single scratch one for Ram
+	std::vector<std::unique_ptr<FrameBuffer>> frames;
+
+public:
+	// count has to be at least 1, std::invalid_argument otherwise
+	NESVectorEnv(const NESCart &cart, int count, Observation observation);
+
+	int size() const { return static_cast<int>(instances.size()); }
+
+	// bytes each instance writes to the observation buffer
+	size_t observationSize() const;
+
+	// powers an instance off and on again, leaving it as it was if the new
+	// one can't be made
+	void reset(int index);
+
+	// whether an instance's CPU has halted, see NES::halted; its frames do
+	// nothing from then on until it's reset
+	bool halted(int index) const { return instances[index]->halted(); }
+
+	// runs a frame of every instance with actions[i], a mask of
+	// NESController::Button, held on instance i's controller 1. Instance i's
+	// observation goes to observations + i * observationSize().
+	void step(const byte *actions, byte *observations);
+};
+
+#endif /* NESVECTORENV_H */
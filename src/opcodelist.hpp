@@ -0,0 +1,79 @@
+#ifndef OPCODELIST_H
+#define OPCODELIST_H
+
+#include <string>
+#include <vector>
+#include "opcodes.hpp"
+
+namespace mos6502
+{
+	// Every opcode the core implements, with what's needed to lay one out in
+	// memory, for the opcode bench and the generated CPU test.
+	struct OpcodeInfo
+	{
+		const std::string &name;
+		byte value;
+		Addressing::Mode mode;
+		short byteSize;
+	};
+
+	template<typename... Opcodes>
+	std::vector<OpcodeInfo> describe()
+	{
+		return {{Opcodes::name, static_cast<byte>(Opcodes::value), Opcodes::addressingMode, Opcodes::byteSize}...};
+	}
+
+	inline std::vector<OpcodeInfo> allOpcodes()
+	{
+		using namespace opcodes;
+		return describe<
+			BRK,
+			ADC::Immediate, ADC::ZeroPage, ADC::ZeroPageX, ADC::Absolute, ADC::AbsoluteX, ADC::AbsoluteY, ADC::IndexedIndirect, ADC::IndirectIndexed,
+			SBC::Immediate, SBC::Immediate_2, SBC::ZeroPage, SBC::ZeroPageX, SBC::Absolute, SBC::AbsoluteX, SBC::AbsoluteY, SBC::IndexedIndirect, SBC::IndirectIndexed,
+			INC::ZeroPage, INC::ZeroPageX, INC::Absolute, INC::AbsoluteX,
+			DEC::ZeroPage, DEC::ZeroPageX, DEC::Absolute, DEC::AbsoluteX,
+			INX, INY, DEX, DEY, TAX, TAY, TXA, TYA, TSX,
+			ORA::Immediate, ORA::ZeroPage, ORA::ZeroPageX, ORA::Absolute, ORA::AbsoluteX, ORA::AbsoluteY, ORA::IndexedIndirect, ORA::IndirectIndexed,
+			EOR::Immediate, EOR::ZeroPage, EOR::ZeroPageX, EOR::Absolute, EOR::AbsoluteX, EOR::AbsoluteY, EOR::IndexedIndirect, EOR::IndirectIndexed,
+			ASL::Accumulator, ASL::ZeroPage, ASL::ZeroPageX, ASL::Absolute, ASL::AbsoluteX,
+			LSR::Accumulator, LSR::ZeroPage, LSR::ZeroPageX, LSR::Absolute, LSR::AbsoluteX,
+			ROL::Accumulator, ROL::ZeroPage, ROL::ZeroPageX, ROL::Absolute, ROL::AbsoluteX,
+			ROR::Accumulator, ROR::ZeroPage, ROR::ZeroPageX, ROR::Absolute, ROR::AbsoluteX,
+			PHP, PHA, PLP,
+			BCS, BCC, BEQ, BMI, BNE, BPL, BVC, BVS,
+			CLC, CLD, SEC, SED, SEI, CLV,
+			JSR,
+			JMP::Absolute, JMP::Indirect,
+			RTS, RTI,
+			BIT::ZeroPage, BIT::Absolute,
+			AND::Immediate, AND::ZeroPage, AND::ZeroPageX, AND::Absolute, AND::AbsoluteX, AND::AbsoluteY, AND::IndexedIndirect, AND::IndirectIndexed,
+			PLA,
+			STY::ZeroPage, STY::ZeroPageX, STY::Absolute,
+			STA::ZeroPage, STA::ZeroPageX, STA::Absolute, STA::AbsoluteX, STA::AbsoluteY, STA::IndexedIndirect, STA::IndirectIndexed,
+			STX::ZeroPage, STX::ZeroPageY, STX::Absolute,
+			TXS,
+			LDX::Immediate, LDX::ZeroPage, LDX::ZeroPageY, LDX::Absolute, LDX::AbsoluteY,
+			LDY::Immediate, LDY::ZeroPage, LDY::ZeroPageX, LDY::Absolute, LDY::AbsoluteX,
+			LDA::Immediate, LDA::ZeroPage, LDA::ZeroPageX, LDA::Absolute, LDA::AbsoluteX, LDA::AbsoluteY, LDA::IndexedIndirect, LDA::IndirectIndexed,
+			CMP::Immediate, CMP::ZeroPage, CMP::ZeroPageX, CMP::Absolute, CMP::AbsoluteX, CMP::AbsoluteY, CMP::IndexedIndirect, CMP::IndirectIndexed,
+			CPX::Immediate, CPX::ZeroPage, CPX::Absolute,
+			CPY::Immediate, CPY::ZeroPage, CPY::Absolute,
+			NOP::ZeroPage::_1, NOP::ZeroPage::_2, NOP::ZeroPage::_3,
+			NOP::Absolute::_1,
+			NOP::ZeroPageX::_1, NOP::ZeroPageX::_2, NOP::ZeroPageX::_3, NOP::ZeroPageX::_4, NOP::ZeroPageX::_5, NOP::ZeroPageX::_6,
+			NOP::Implicit::Official, NOP::Implicit::_1, NOP::Implicit::_2, NOP::Implicit::_3, NOP::Implicit::_4, NOP::Implicit::_5, NOP::Implicit::_6,
+			NOP::Immediate,
+			NOP::AbsoluteX::_1, NOP::AbsoluteX::_2, NOP::AbsoluteX::_3, NOP::AbsoluteX::_4, NOP::AbsoluteX::_5, NOP::AbsoluteX::_6,
+			LAX::ZeroPage, LAX::ZeroPageY, LAX::Absolute, LAX::AbsoluteY, LAX::IndexedIndirect, LAX::IndirectIndexed,
+			SAX::ZeroPage, SAX::ZeroPageY, SAX::Absolute, SAX::IndexedIndirect,
+			DCP::ZeroPage, DCP::ZeroPageX, DCP::Absolute, DCP::AbsoluteX, DCP::AbsoluteY, DCP::IndexedIndirect, DCP::IndirectIndexed,
+			ISC::ZeroPage, ISC::ZeroPageX, ISC::Absolute, ISC::AbsoluteX, ISC::AbsoluteY, ISC::IndexedIndirect, ISC::IndirectIndexed,
+			SLO::ZeroPage, SLO::ZeroPageX, SLO::Absolute, SLO::AbsoluteX, SLO::AbsoluteY, SLO::IndexedIndirect, SLO::IndirectIndexed,
+			RLA::ZeroPage, RLA::ZeroPageX, RLA::Absolute, RLA::AbsoluteX, RLA::AbsoluteY, RLA::IndexedIndirect, RLA::IndirectIndexed,
+			SRE::ZeroPage, SRE::ZeroPageX, SRE::Absolute, SRE::AbsoluteX, SRE::AbsoluteY, SRE::IndexedIndirect, SRE::IndirectIndexed,
+			RRA::ZeroPage, RRA::ZeroPageX, RRA::Absolute, RRA::AbsoluteX, RRA::AbsoluteY, RRA::IndexedIndirect, RRA::IndirectIndexed
+		>();
+	}
+}
+
+#endif /* OPCODELIST_H */
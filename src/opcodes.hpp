@@ -20,7 +20,7 @@ namespace mos6502 { namespace opcodes
 	{
 		static constexpr const char *group = "ADC";
 		static constexpr byte flags = N|Z|C|V;
-		static constexpr byte manual = C;
+		static constexpr byte manual = flags;
 		struct Immediate : Addr::Immediate<0x69, 2, flags, manual> { static inline Asm name{group}; };
 		struct ZeroPage: Addr::ZeroPage<0x65, 3, flags, manual> { static inline Asm name{group}; };
 		struct ZeroPageX: Addr::ZeroPageX<0x75, 4, flags, manual> { static inline Asm name{group}; };
@@ -35,7 +35,7 @@ namespace mos6502 { namespace opcodes
 	{
 		static constexpr const char *group = "SBC";
 		static constexpr byte flags = N|Z|C|V;
-		static constexpr byte manual = C|V;
+		static constexpr byte manual = flags;
 		struct Immediate : Addr::Immediate<0xe9, 2, flags, manual> { static inline Asm name{group}; };
 		struct Immediate_2 : Addr::Immediate<0xeb, 2, flags, manual> { static inline Asm name{group}; };
 		struct ZeroPage: Addr::ZeroPage<0xe5, 3, flags, manual> { static inline Asm name{group}; };
@@ -398,7 +398,7 @@ namespace mos6502 { namespace opcodes
 	{
 		static constexpr const char *group = "ISC";
 		static constexpr byte flags = N|V|Z|C;
-		static constexpr byte manual = V|C;
+		static constexpr byte manual = flags;
 		struct ZeroPage : Addr::ZeroPage<0xe7, 5, flags, manual> { static inline Asm name{group}; };
 		struct ZeroPageX : Addr::ZeroPageX<0xf7, 6, flags, manual> { static inline Asm name{group}; };
 		struct Absolute : Addr::Absolute<0xef, 6, flags, manual> { static inline Asm name{group}; };
@@ -454,7 +454,7 @@ namespace mos6502 { namespace opcodes
 	{
 		static constexpr const char *group = "RRA";
 		static constexpr byte flags = N|V|Z|C;
-		static constexpr byte manual = C;
+		static constexpr byte manual = flags;
 		struct ZeroPage : Addr::ZeroPage<0x67, 5, flags, manual> { static inline Asm name{group}; };
 		struct ZeroPageX : Addr::ZeroPageX<0x77, 6, flags, manual> { static inline Asm name{group}; };
 		struct Absolute : Addr::Absolute<0x6f, 6, flags, manual> { static inline Asm name{group}; };
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "movie.hpp"
+#include "movieplayer.hpp"
+#include "nescart.hpp"
+
+// Headless movie player: runs a ROM under the input of an FM2 movie, see
+// movie.hpp. With --hashes it writes a line per frame with the frame number
+// and hashes of CPU RAM and the picture to a file, so two runs or two builds
+// can be diffed. How long the run took goes to cerr, which makes a movie a
+// repeatable benchmark too.
+
+int main(int argc, const char *argv[])
+{
+	std::string hashPath;
+	long frameLimit = -1;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg(argv[i]);
+		if (arg == "--hashes" && i + 1 < argc)
+		{
+			hashPath = argv[++i];
+		}
+		else if (arg == "--frames" && i + 1 < argc)
+		{
+			frameLimit = std::stol(argv[++i]);
+		}
+		else
+		{
+			paths.push_back(arg);
+		}
+	}
+	if (paths.size() != 2)
+	{
+		std::cerr << "usage: " << argv[0] << " [--hashes file] [--frames n] rom movie.fm2" << std::endl;
+		return 1;
+	}
+
+	NESCart cart(paths[0]);
+	Movie movie;
+	if (!movie.read(paths[1]))
+	{
+		return 1;
+	}
+	std::ofstream hashFile;
+	if (!hashPath.empty())
+	{
+		hashFile.open(hashPath);
+		if (!hashFile)
+		{
+			std::cerr << "Can't write " << hashPath << std::endl;
+			return 1;
+		}
+	}
+
+	const long frames = frameLimit >= 0 ? std::min<long>(frameLimit, movie.frames.size()) : movie.frames.size();
+	const auto start = std::chrono::steady_clock::now();
+	playMovie(cart, movie, frames, [&](long i, const NES &nes, const FrameBuffer &frame) {
+		if (hashFile.is_open())
+		{
+			writeFrameHashes(hashFile, i, nes, frame);
+		}
+	});
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << std::dec << std::fixed << std::setprecision(3) << frames << " frames in " << seconds << "s, "
+			  << std::setprecision(1) << frames / seconds << " frames/s" << std::endl;
+	return 0;
+}
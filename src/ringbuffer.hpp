@@ -0,0 +1,55 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single producer, single consumer ring. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class RingBuffer
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+	static constexpr size_t mask = Capacity - 1;
+
+	std::array<T, Capacity> items;
+	std::atomic<size_t> head; // next write, owned by the producer
+	std::atomic<size_t> tail; // next read, owned by the consumer
+
+public:
+	RingBuffer() : head(0), tail(0) {}
+
+	size_t size() const
+	{
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+	}
+
+	// returns the number of items actually pushed
+	size_t push(const T *data, size_t count)
+	{
+		const size_t writeIndex = head.load(std::memory_order_relaxed);
+		count = std::min(count, Capacity - (writeIndex - tail.load(std::memory_order_acquire)));
+		for (size_t i = 0; i < count; ++i)
+		{
+			items[(writeIndex + i) & mask] = data[i];
+		}
+		head.store(writeIndex + count, std::memory_order_release);
+		return count;
+	}
+
+	// returns the number of items actually popped
+	size_t pop(T *data, size_t count)
+	{
+		const size_t readIndex = tail.load(std::memory_order_relaxed);
+		count = std::min(count, head.load(std::memory_order_acquire) - readIndex);
+		for (size_t i = 0; i < count; ++i)
+		{
+			data[i] = items[(readIndex + i) & mask];
+		}
+		tail.store(readIndex + count, std::memory_order_release);
+		return count;
+	}
+};
+
+#endif /* RINGBUFFER_H */
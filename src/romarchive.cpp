@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "romarchive.hpp"
+
+namespace
+{
+	constexpr uint32_t zipLocalHeader = 0x04034b50;
+	constexpr uint32_t zipCentralHeader = 0x02014b50;
+	constexpr uint32_t zipEndOfDirectory = 0x06054b50;
+	constexpr size_t zipLocalHeaderSize = 30;
+	constexpr size_t zipCentralHeaderSize = 46;
+	constexpr size_t zipEndOfDirectorySize = 22;
+	constexpr size_t zipMaxComment = 0xffff;
+	constexpr int zipStored = 0;
+	constexpr int zipDeflated = 8;
+
+	uint16_t little16(const byte *data)
+	{
+		return data[0] | (data[1] << 8);
+	}
+
+	uint32_t little32(const byte *data)
+	{
+		return little16(data) | (static_cast<uint32_t>(little16(data + 2)) << 16);
+	}
+
+	bool isNESFile(const std::string &name)
+	{
+		if (name.size() < 4)
+		{
+			return false;
+		}
+		std::string extension = name.substr(name.size() - 4);
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+					   [](unsigned char c) { return std::tolower(c); });
+		return extension == ".nes";
+	}
+}
+
+RomFormat detectRomFormat(const std::string &path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	byte magic[4] = {};
+	file.read(reinterpret_cast<char *>(magic), sizeof(magic));
+	if (magic[0] == 0x1f && magic[1] == 0x8b)
+	{
+		return RomFormat::Gzip;
+	}
+	if (file.gcount() == 4 && little32(magic) == zipLocalHeader)
+	{
+		return RomFormat::Zip;
+	}
+	return RomFormat::Plain;
+}
+
+InflateStreamBuf::int_type InflateStreamBuf::underflow()
+{
+	if (gptr() < egptr())
+	{
+		return traits_type::to_int_type(*gptr());
+	}
+	const size_t produced = inflateInto(buffer.data(), buffer.size());
+	if (produced == 0)
+	{
+		return traits_type::eof();
+	}
+	setg(buffer.data(), buffer.data(), buffer.data() + produced);
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize InflateStreamBuf::xsgetn(char *out, std::streamsize count)
+{
+	// whatever's buffered first, then decompress into out itself
+	std::streamsize copied = std::min<std::streamsize>(count, egptr() - gptr());
+	std::memcpy(out, gptr(), copied);
+	gbump(copied);
+	while (copied < count)
+	{
+		const size_t produced = inflateInto(out + copied, count - copied);
+		if (produced == 0)
+		{
+			break;
+		}
+		copied += produced;
+	}
+	return copied;
+}
+
+GzipStreamBuf::GzipStreamBuf(const std::string &path)
+{
+	file = gzopen(path.c_str(), "rb");
+	if (file)
+	{
+		gzbuffer(file, bufferSize * 4);
+	}
+}
+
+GzipStreamBuf::~GzipStreamBuf()
+{
+	if (file)
+	{
+		gzclose(file);
+	}
+}
+
+size_t GzipStreamBuf::inflateInto(char *out, size_t count)
+{
+	if (!file)
+	{
+		return 0;
+	}
+	// gzread takes an unsigned int count
+	const int produced = gzread(file, out, static_cast<unsigned>(std::min<size_t>(count, 1u << 30)));
+	return produced > 0 ? produced : 0;
+}
+
+ZipStreamBuf::ZipStreamBuf(const std::string &path)
+	: file(path, std::ios::in | std::ios::binary), stream(), streamReady(false), stored(false), remainingInput(0)
+{
+	if (file.is_open() && !findEntry())
+	{
+		std::cerr << "No .nes file in zip archive " << path << std::endl;
+	}
+}
+
+ZipStreamBuf::~ZipStreamBuf()
+{
+	if (streamReady && !stored)
+	{
+		inflateEnd(&stream);
+	}
+}
+
+// finds the entry through the central directory, since local headers can
+// leave the sizes to a descriptor after the data
+bool ZipStreamBuf::findEntry()
+{
+	file.seekg(0, std::ios::end);
+	const size_t fileSize = file.tellg();
+	if (fileSize < zipEndOfDirectorySize)
+	{
+		return false;
+	}
+	const size_t tailSize = std::min(fileSize, zipEndOfDirectorySize + zipMaxComment);
+	std::vector<byte> tail(tailSize);
+	file.seekg(fileSize - tailSize);
+	file.read(reinterpret_cast<char *>(tail.data()), tailSize);
+
+	// the end of directory record is followed by a comment of up to 64K
+	size_t end = tailSize - zipEndOfDirectorySize;
+	while (little32(&tail[end]) != zipEndOfDirectory)
+	{
+		if (end == 0)
+		{
+			return false;
+		}
+		--end;
+	}
+	const uint16_t entries = little16(&tail[end + 10]);
+	const uint32_t directoryOffset = little32(&tail[end + 16]);
+
+	file.seekg(directoryOffset);
+	for (int entry = 0; entry < entries; ++entry)
+	{
+		byte header[zipCentralHeaderSize];
+		if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || little32(header) != zipCentralHeader)
+		{
+			return false;
+		}
+		const int method = little16(header + 10);
+		const uint32_t compressedSize = little32(header + 20);
+		const uint16_t nameLength = little16(header + 28);
+		const uint16_t extraLength = little16(header + 30);
+		const uint16_t commentLength = little16(header + 32);
+		const uint32_t localOffset = little32(header + 42);
+		std::string name(nameLength, '\0');
+		file.read(&name[0], nameLength);
+		file.seekg(extraLength + commentLength, std::ios::cur);
+
+		if (!isNESFile(name) || (method != zipStored && method != zipDeflated))
+		{
+			continue;
+		}
+
+		byte local[zipLocalHeaderSize];
+		file.seekg(localOffset);
+		if (!file.read(reinterpret_cast<char *>(local), sizeof(local)) || little32(local) != zipLocalHeader)
+		{
+			return false;
+		}
+		file.seekg(little16(local + 26) + little16(local + 28), std::ios::cur);
+
+		stored = method == zipStored;
+		remainingInput = compressedSize;
+		if (!stored && inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		{
+			return false;
+		}
+		streamReady = true;
+		return true;
+	}
+	return false;
+}
+
+size_t ZipStreamBuf::inflateInto(char *out, size_t count)
+{
+	if (!streamReady)
+	{
+		return 0;
+	}
+	if (stored)
+	{
+		const size_t length = std::min(count, remainingInput);
+		file.read(out, length);
+		remainingInput -= file.gcount();
+		return file.gcount();
+	}
+
+	stream.next_out = reinterpret_cast<Bytef *>(out);
+	stream.avail_out = static_cast<uInt>(std::min<size_t>(count, 1u << 30));
+	while (stream.avail_out > 0)
+	{
+		if (stream.avail_in == 0 && remainingInput > 0)
+		{
+			file.read(input.data(), std::min(input.size(), remainingInput));
+			remainingInput -= file.gcount();
+			stream.next_in = reinterpret_cast<Bytef *>(input.data());
+			stream.avail_in = file.gcount();
+		}
+		const int result = inflate(&stream, Z_NO_FLUSH);
+		if (result == Z_STREAM_END)
+		{
+			break;
+		}
+		if (result != Z_OK || (stream.avail_in == 0 && remainingInput == 0))
+		{
+			if (result != Z_OK)
+			{
+				std::cerr << "Zip entry is corrupt" << std::endl;
+			}
+			break;
+		}
+	}
+	return reinterpret_cast<char *>(stream.next_out) - out;
+}
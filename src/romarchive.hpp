@@ -0,0 +1,77 @@
+#ifndef ROMARCHIVE_H
+#define ROMARCHIVE_H
+
+#include <array>
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <zlib.h>
+#include "common.hpp"
+
+// Stream buffers that inflate compressed ROMs as NESCart reads them, so PRG
+// and CHR data is decompressed straight into the cart's buffers. Large reads
+// bypass the internal buffer and inflate directly into the caller's memory.
+
+enum class RomFormat
+{
+	Plain,
+	Gzip,
+	Zip
+};
+
+// works out the format from the file's first bytes
+RomFormat detectRomFormat(const std::string &path);
+
+class InflateStreamBuf : public std::streambuf
+{
+protected:
+	static constexpr size_t bufferSize = 16384;
+	std::array<char, bufferSize> buffer;
+
+	// decompresses up to count bytes into out, returning how many were
+	// produced, 0 at the end of the data or on error
+	virtual size_t inflateInto(char *out, size_t count) = 0;
+
+	int_type underflow() override;
+	std::streamsize xsgetn(char *out, std::streamsize count) override;
+};
+
+// gzip files through zlib's gz interface
+class GzipStreamBuf : public InflateStreamBuf
+{
+	gzFile file;
+
+	size_t inflateInto(char *out, size_t count) override;
+
+public:
+	GzipStreamBuf(const std::string &path);
+	~GzipStreamBuf();
+	GzipStreamBuf(const GzipStreamBuf &) = delete;
+	GzipStreamBuf &operator=(const GzipStreamBuf &) = delete;
+
+	bool isOpen() const { return file != nullptr; }
+};
+
+// the first .nes file in a zip archive, stored or deflated
+class ZipStreamBuf : public InflateStreamBuf
+{
+	std::ifstream file;
+	z_stream stream;
+	bool streamReady;
+	bool stored;
+	size_t remainingInput; // compressed bytes of the entry not read yet
+	std::array<char, bufferSize> input;
+
+	bool findEntry();
+	size_t inflateInto(char *out, size_t count) override;
+
+public:
+	ZipStreamBuf(const std::string &path);
+	~ZipStreamBuf();
+	ZipStreamBuf(const ZipStreamBuf &) = delete;
+	ZipStreamBuf &operator=(const ZipStreamBuf &) = delete;
+
+	bool isOpen() const { return streamReady; }
+};
+
+#endif /* ROMARCHIVE_H */
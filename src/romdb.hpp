@@ -0,0 +1,68 @@
+#ifndef ROMDB_H
+#define ROMDB_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "common.hpp"
+#include "nescart.hpp"
+
+// Header corrections for known dumps, keyed by the CRC-32 of PRG-ROM followed
+// by CHR-ROM. The table is generated from data/romdb.txt at build time.
+
+enum class RomMirroring
+{
+	Header, // the header has it right
+	Horizontal,
+	Vertical,
+	FourScreen
+};
+
+struct RomDbEntry
+{
+	uint32_t crc;
+	uint16_t mapper;
+	byte submapper;
+	RomMirroring mirroring;
+	bool battery;
+	Timing timing;
+};
+
+#if __has_include("romdb_table.hpp")
+#include "romdb_table.hpp"
+#else
+// built without CMake generating the table
+constexpr std::array<RomDbEntry, 0> romDbEntries = {};
+#endif
+
+namespace romdb_detail
+{
+	constexpr bool sorted()
+	{
+		for (size_t i = 1; i < romDbEntries.size(); ++i)
+		{
+			if (romDbEntries[i - 1].crc >= romDbEntries[i].crc)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(sorted(), "ROM database entries must be sorted and unique");
+}
+
+// binary search of a table sorted by CRC, null when the dump isn't in it
+inline const RomDbEntry *findRom(uint32_t crc, const RomDbEntry *begin, const RomDbEntry *end)
+{
+	const RomDbEntry *entry = std::lower_bound(begin, end, crc,
+											   [](const RomDbEntry &entry, uint32_t crc) { return entry.crc < crc; });
+	return entry != end && entry->crc == crc ? entry : nullptr;
+}
+
+inline const RomDbEntry *findRom(uint32_t crc)
+{
+	return findRom(crc, romDbEntries.data(), romDbEntries.data() + romDbEntries.size());
+}
+
+#endif /* ROMDB_H */
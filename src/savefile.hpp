@@ -0,0 +1,97 @@
+#ifndef SAVEFILE_H
+#define SAVEFILE_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "common.hpp"
+
+enum class SaveSync
+{
+	None, // leave writing back to the kernel, survives the emulator crashing
+	Async, // schedule a write back at the end of every frame that changed it
+	Sync // wait for the write back at the end of every frame that changed it
+};
+
+// Battery backed cart RAM mapped straight from a .sav file with MAP_SHARED,
+// so every write the CPU makes is already a write to the file.
+class SaveFile
+{
+	int fd;
+	byte *memory;
+	size_t length;
+
+public:
+	SaveFile() : fd(-1), memory(nullptr), length(0) {}
+	SaveFile(const SaveFile &) = delete;
+	SaveFile &operator=(const SaveFile &) = delete;
+
+	~SaveFile()
+	{
+		close();
+	}
+
+	// maps size bytes of path, creating or growing the file as needed,
+	// returns false and leaves nothing mapped if it can't
+	bool open(const std::string &path, size_t size)
+	{
+		close();
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+		{
+			std::cerr << "Can't open save file " << path << std::endl;
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) < size && ftruncate(fd, size) != 0))
+		{
+			std::cerr << "Can't resize save file " << path << std::endl;
+			close();
+			return false;
+		}
+
+		void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			std::cerr << "Can't map save file " << path << std::endl;
+			close();
+			return false;
+		}
+		memory = static_cast<byte *>(mapped);
+		length = size;
+		return true;
+	}
+
+	void close()
+	{
+		if (memory)
+		{
+			munmap(memory, length);
+			memory = nullptr;
+			length = 0;
+		}
+		if (fd >= 0)
+		{
+			::close(fd);
+			fd = -1;
+		}
+	}
+
+	void sync(SaveSync mode)
+	{
+		if (memory && mode != SaveSync::None)
+		{
+			msync(memory, length, mode == SaveSync::Sync ? MS_SYNC : MS_ASYNC);
+		}
+	}
+
+	byte *data() { return memory; }
+	size_t size() const { return length; }
+};
+
+#endif /* SAVEFILE_H */
@@ -15,6 +15,7 @@ namespace mos6502
 		long totalCycles;
 		short byteStep;
 		byte operand1, operand2, opcodeResult;
+		bool halted; // by an opcode the core doesn't run, until reset
 
 		State()
 		{
@@ -25,6 +26,7 @@ namespace mos6502
 
 			cycles = pageCrossCycles = totalCycles = 0;
 			byteStep = 0;
+			halted = false;
 		}
 
 		inline void setA(byte value)
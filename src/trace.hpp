@@ -0,0 +1,44 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+
+namespace mos6502
+{
+
+// the per instruction trace on stdout is only built with NESEBAR_TRACE defined
+#ifdef NESEBAR_TRACE
+constexpr bool traceEnabled = true;
+#else
+constexpr bool traceEnabled = false;
+#endif
+
+// stands in for std::cout in the trace, without NESEBAR_TRACE everything
+// written to it is dropped before being formatted
+struct TraceStream
+{
+	template<typename T>
+	TraceStream &operator<<(const T &value)
+	{
+		if (traceEnabled)
+		{
+			std::cout << value;
+		}
+		return *this;
+	}
+
+	TraceStream &operator<<(std::ostream &(*manipulator)(std::ostream &))
+	{
+		if (traceEnabled)
+		{
+			std::cout << manipulator;
+		}
+		return *this;
+	}
+};
+
+inline TraceStream trace;
+
+}
+
+#endif /* TRACE_H */
@@ -0,0 +1,50 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include "common.hpp"
+
+// Single producer, single consumer exchange. The producer always owns the back
+// buffer and the consumer the front buffer; the middle buffer is swapped
+// atomically so neither side ever waits on the other.
+template<typename T>
+class TripleBuffer
+{
+	static constexpr byte freshBit = 0b100;
+	static constexpr byte indexMask = 0b011;
+
+	std::array<T, 3> buffers;
+	std::atomic<byte> middle;
+	byte back, front;
+
+public:
+	TripleBuffer() : middle(1), back(0), front(2) {}
+
+	// producer side
+	T &writeBuffer()
+	{
+		return buffers[back];
+	}
+	void publish()
+	{
+		back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// consumer side, returns true if a newer buffer was picked up
+	bool consume()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & freshBit))
+		{
+			return false;
+		}
+		front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	const T &readBuffer() const
+	{
+		return buffers[front];
+	}
+};
+
+#endif /* TRIPLEBUFFER_H */
@@ -0,0 +1,68 @@
+#include <memory>
+#include <string>
+#include "catch.hpp"
+
+#include "../src/batchrunner.hpp"
+#include "../src/nes.hpp"
+#include "testcarts.hpp"
+
+// strobes controller 1 in a loop and runs two more instructions each time
+// A is held
+static NESCart inputLoopCart()
+{
+	return nromCart({
+		0xa9, 0x01, 0x8d, 0x16, 0x40, // LDA #1, STA $4016
+		0xa9, 0x00, 0x8d, 0x16, 0x40, // LDA #0, STA $4016
+		0xad, 0x16, 0x40, 0x29, 0x01, // LDA $4016, AND #1
+		0xf0, 0xef, // BEQ $8000
+		0xe8, 0xe8, // INX, INX
+		0x4c, 0x00, 0x80 // JMP $8000
+	});
+}
+
+TEST_CASE("Batch runs match running each job alone", "[BatchRunner]")
+{
+	const NESCart cart = inputLoopCart();
+	const std::vector<byte> released;
+	const std::vector<byte> holdA(3, NESController::A);
+	const long frames = 4;
+
+	std::vector<BatchJob> jobs;
+	for (int i = 0; i < 6; ++i)
+	{
+		jobs.push_back({&cart, i % 2 ? &holdA : &released, frames});
+	}
+	BatchRunner runner(3);
+	const std::vector<BatchResult> results = runner.run(jobs);
+	REQUIRE(results.size() == jobs.size());
+
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		auto nes = std::make_unique<NES>(cart);
+		auto frame = std::make_unique<FrameBuffer>();
+		for (long f = 0; f < frames; ++f)
+		{
+			nes->setButtons(0, static_cast<size_t>(f) < jobs[i].inputs->size() ? (*jobs[i].inputs)[f] : 0);
+			nes->runFrame(*frame);
+		}
+		REQUIRE(results[i].instructions == nes->instructionCount());
+		REQUIRE(results[i].lastFrameHash == frameHash(*frame));
+	}
+	REQUIRE(results[0].instructions != results[1].instructions);
+}
+
+TEST_CASE("A job whose CPU halts doesn't stop the others", "[BatchRunner]")
+{
+	const NESCart cart = inputLoopCart();
+	const NESCart jam = nromCart({0xe8, 0x02}); // INX, JAM
+	const std::vector<byte> released;
+	const std::vector<BatchJob> jobs = {{&cart, &released, 3}, {&jam, &released, 3}, {&cart, &released, 3}};
+	const std::vector<BatchResult> results = BatchRunner(2).run(jobs);
+
+	REQUIRE_FALSE(results[0].halted);
+	REQUIRE(results[1].halted);
+	REQUIRE(results[1].instructions == 1);
+	REQUIRE_FALSE(results[2].halted);
+	REQUIRE(results[2].instructions == results[0].instructions);
+	REQUIRE(results[2].lastFrameHash == results[0].lastFrameHash);
+}
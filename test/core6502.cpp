@@ -0,0 +1,189 @@
+#include "catch.hpp"
+
+#include "../src/core6502.hpp"
+#include "../src/flatbus.hpp"
+
+TEST_CASE("Core runs on a flat RAM bus", "[Core]")
+{
+	const byte program[] = {
+		0xa9, 0x05, // LDA #$05
+		0x18, // CLC
+		0x69, 0x03, // ADC #$03
+		0x85, 0x10, // STA $10
+		0xa2, 0x10, // LDX #$10
+		0xe8, // INX
+		0x8e, 0x00, 0x03 // STX $0300
+	};
+	const byte resetVector[] = {0x00, 0x02};
+
+	FlatBus bus;
+	bus.load(0x0200, program, sizeof(program));
+	bus.load(0xfffc, resetVector, sizeof(resetVector));
+
+	mos6502::Core<FlatBus, false> cpu(bus);
+	cpu.reset();
+	REQUIRE(cpu.getState().pc.value == 0x0200);
+	for (int i = 0; i < 7; ++i)
+	{
+		cpu.step();
+	}
+
+	REQUIRE(cpu.getState().a == 0x08);
+	REQUIRE(cpu.getState().x == 0x11);
+	REQUIRE(cpu.getState().pc.value == 0x0200 + sizeof(program));
+	REQUIRE(cpu.getState().totalCycles == 7 + 17);
+	REQUIRE(bus.peek(0x0010) == 0x08);
+	REQUIRE(bus.peek(0x0300) == 0x11);
+}
+
+TEST_CASE("JAM halts the core on the opcode until reset", "[Core]")
+{
+	const byte program[] = {
+		0xe8, // INX
+		0x02, // JAM
+		0xe8 // INX
+	};
+	const byte resetVector[] = {0x00, 0x02};
+
+	FlatBus bus;
+	bus.load(0x0200, program, sizeof(program));
+	bus.load(0xfffc, resetVector, sizeof(resetVector));
+
+	mos6502::Core<FlatBus, false> cpu(bus);
+	cpu.reset();
+	REQUIRE(cpu.step());
+	REQUIRE_FALSE(cpu.step());
+	REQUIRE_FALSE(cpu.step());
+	REQUIRE(cpu.getState().halted);
+	REQUIRE(cpu.getState().pc.value == 0x0201);
+	REQUIRE(cpu.getState().x == 1);
+
+	cpu.reset();
+	REQUIRE_FALSE(cpu.getState().halted);
+	REQUIRE(cpu.step());
+}
+
+namespace
+{
+	// runs SED or CLD, SEC or CLC, LDA #a and then ADC or SBC #operand
+	template<bool DecimalMode>
+	class ArithmeticRunner
+	{
+		FlatBus bus;
+		mos6502::Core<FlatBus, DecimalMode> cpu;
+
+	public:
+		ArithmeticRunner() : cpu(bus)
+		{
+			const byte resetVector[] = {0x00, 0x02};
+			bus.load(0xfffc, resetVector, sizeof(resetVector));
+		}
+
+		const mos6502::State &run(byte opcode, bool decimal, bool carry, byte a, byte operand)
+		{
+			const byte program[] = {
+				static_cast<byte>(decimal ? 0xf8 : 0xd8),
+				static_cast<byte>(carry ? 0x38 : 0x18),
+				0xa9, a,
+				opcode, operand
+			};
+			bus.load(0x0200, program, sizeof(program));
+			cpu.reset();
+			for (int i = 0; i < 4; ++i)
+			{
+				cpu.step();
+			}
+			return cpu.getState();
+		}
+	};
+
+	constexpr byte adcImmediate = 0x69;
+	constexpr byte sbcImmediate = 0xe9;
+	constexpr byte flagN = 0x80, flagV = 0x40, flagZ = 0x02, flagC = 0x01;
+
+	int fromBCD(int value)
+	{
+		return (value >> 4) * 10 + (value & 0x0f);
+	}
+
+	int toBCD(int value)
+	{
+		return ((value / 10) << 4) | (value % 10);
+	}
+
+	bool isBCD(int value)
+	{
+		return (value & 0x0f) < 10 && (value >> 4) < 10;
+	}
+}
+
+TEST_CASE("Decimal mode ADC and SBC for every input", "[Core]")
+{
+	const mos6502::DecimalTable &table = mos6502::DecimalTable::get();
+	int wrongResults = 0, wrongFlags = 0;
+	for (int carry = 0; carry < 2; ++carry)
+	{
+		for (int a = 0; a < 256; ++a)
+		{
+			for (int operand = 0; operand < 256; ++operand)
+			{
+				// valid BCD gives the decimal answer, Z is always the binary
+				// one, and SBC takes every flag from the binary difference
+				const uint16_t sumEntry = table.adc(carry, a, operand);
+				const byte sum = sumEntry & 0xff, sumFlags = sumEntry >> 8;
+				const int binarySum = a + operand + carry;
+				wrongFlags += ((sumFlags & flagZ) != 0) != ((binarySum & 0xff) == 0);
+				if (isBCD(a) && isBCD(operand))
+				{
+					const int decimalSum = fromBCD(a) + fromBCD(operand) + carry;
+					wrongResults += sum != toBCD(decimalSum % 100);
+					wrongFlags += ((sumFlags & flagC) != 0) != (decimalSum >= 100);
+				}
+
+				const uint16_t differenceEntry = table.sbc(carry, a, operand);
+				const byte difference = differenceEntry & 0xff, differenceFlags = differenceEntry >> 8;
+				const int binaryDifference = a - operand - 1 + carry;
+				const byte binaryFlags = (binaryDifference & 0x80 ? flagN : 0)
+					| ((a ^ operand) & (a ^ binaryDifference) & 0x80 ? flagV : 0)
+					| ((binaryDifference & 0xff) == 0 ? flagZ : 0)
+					| (binaryDifference >= 0 ? flagC : 0);
+				wrongFlags += differenceFlags != binaryFlags;
+				if (isBCD(a) && isBCD(operand))
+				{
+					const int decimalDifference = fromBCD(a) - fromBCD(operand) - 1 + carry;
+					wrongResults += difference != toBCD((decimalDifference + 100) % 100);
+				}
+			}
+		}
+	}
+	REQUIRE(wrongResults == 0);
+	REQUIRE(wrongFlags == 0);
+}
+
+TEST_CASE("Decimal mode N and V quirks", "[Core]")
+{
+	ArithmeticRunner<true> runner;
+
+	// N and V come from the sum before the high digit is adjusted
+	const mos6502::State &wrap = runner.run(adcImmediate, true, false, 0x99, 0x01);
+	REQUIRE(wrap.a == 0x00);
+	REQUIRE((wrap.p & (flagN | flagV | flagZ | flagC)) == (flagN | flagC));
+
+	const mos6502::State &overflow = runner.run(adcImmediate, true, true, 0x79, 0x00);
+	REQUIRE(overflow.a == 0x80);
+	REQUIRE((overflow.p & (flagN | flagV | flagZ | flagC)) == (flagN | flagV));
+
+	const mos6502::State &both = runner.run(adcImmediate, true, false, 0x50, 0x50);
+	REQUIRE(both.a == 0x00);
+	REQUIRE((both.p & (flagN | flagV | flagZ | flagC)) == (flagN | flagV | flagC));
+
+	// invalid digits
+	REQUIRE(runner.run(adcImmediate, true, false, 0x0f, 0x01).a == 0x16);
+	REQUIRE(runner.run(sbcImmediate, true, true, 0x00, 0x01).a == 0x99);
+	REQUIRE(runner.run(sbcImmediate, true, true, 0x10, 0x0f).a == 0x0b);
+
+	// binary mode is untouched, and so is a core built without decimal mode
+	REQUIRE(runner.run(adcImmediate, false, false, 0x09, 0x01).a == 0x0a);
+	ArithmeticRunner<false> binaryRunner;
+	REQUIRE(binaryRunner.run(adcImmediate, true, false, 0x09, 0x01).a == 0x0a);
+}
@@ -0,0 +1,35 @@
+#include <cstring>
+#include <vector>
+#include "catch.hpp"
+
+#include "../src/crc32.hpp"
+
+TEST_CASE("CRC-32 check value", "[CRC32]")
+{
+	const char *check = "123456789";
+	REQUIRE(calculateCRC32(reinterpret_cast<const byte *>(check), std::strlen(check)) == 0xcbf43926);
+	REQUIRE(calculateCRC32(nullptr, 0) == 0);
+}
+
+TEST_CASE("CRC-32 in pieces matches the whole", "[CRC32]")
+{
+	std::vector<byte> data(1021);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<byte>(i * 37 + (i >> 3));
+	}
+
+	// byte at a time against the sliced path, at every split point alignment
+	uint32_t bytewise = 0;
+	for (byte value : data)
+	{
+		bytewise = calculateCRC32(&value, 1, bytewise);
+	}
+	const uint32_t whole = calculateCRC32(data.data(), data.size());
+	REQUIRE(whole == bytewise);
+	for (size_t split : {1, 7, 8, 9, 500, 1020})
+	{
+		const uint32_t first = calculateCRC32(data.data(), split);
+		REQUIRE(calculateCRC32(data.data() + split, data.size() - split, first) == whole);
+	}
+}
@@ -0,0 +1,110 @@
+#include <memory>
+#include <string>
+#include "catch.hpp"
+
+#include "../src/debugger.hpp"
+#include "testcarts.hpp"
+
+TEST_CASE("Execution breakpoints stop before the instruction", "[Debugger]")
+{
+	const NESCart cart = countingCart();
+	NES nes(cart);
+	nes.setButtons(0, NESController::A);
+	Debugger debugger(nes);
+	debugger.setBreakpoint(mos6502::Breakpoints::Execute, 0x8011);
+
+	REQUIRE_FALSE(debugger.runFrames());
+	REQUIRE(nes.cpuState().pc.value == 0x8011);
+	REQUIRE(debugger.getBreakpoints().stoppedBy() == mos6502::Breakpoints::Execute);
+	REQUIRE(nes.ram()[0] == 0);
+
+	// stepping runs the instruction the CPU stopped at
+	REQUIRE(debugger.step());
+	REQUIRE(nes.ram()[0] == 1);
+	REQUIRE(nes.cpuState().pc.value == 0x8013);
+
+	// and the next time round it stops there again
+	REQUIRE_FALSE(debugger.step(100));
+	REQUIRE(nes.cpuState().pc.value == 0x8011);
+	REQUIRE(nes.ram()[0] == 1);
+
+	debugger.clearBreakpoint(mos6502::Breakpoints::Execute, 0x8011);
+	REQUIRE(debugger.runFrames(2));
+	REQUIRE(nes.ram()[0] != 1);
+}
+
+TEST_CASE("Watchpoints stop after the instruction", "[Debugger]")
+{
+	const NESCart cart = countingCart();
+	NES nes(cart);
+	nes.setButtons(0, NESController::A);
+	Debugger debugger(nes);
+
+	debugger.setBreakpoint(mos6502::Breakpoints::Read, 0x4016);
+	REQUIRE_FALSE(debugger.runFrames());
+	REQUIRE(debugger.getBreakpoints().stoppedBy() == mos6502::Breakpoints::Read);
+	REQUIRE(debugger.getBreakpoints().stoppedAt().value == 0x4016);
+	REQUIRE(nes.cpuState().pc.value == 0x800d);
+	debugger.clearBreakpoint(mos6502::Breakpoints::Read, 0x4016);
+
+	debugger.setBreakpoint(mos6502::Breakpoints::Write, 0x0000);
+	REQUIRE_FALSE(debugger.runFrames());
+	REQUIRE(debugger.getBreakpoints().stoppedBy() == mos6502::Breakpoints::Write);
+	REQUIRE(nes.cpuState().pc.value == 0x8013);
+	REQUIRE(nes.ram()[0] == 1);
+}
+
+TEST_CASE("A debugged machine without breakpoints runs like any other", "[Debugger]")
+{
+	const NESCart cart = countingCart();
+	NES plain(cart);
+	NES debugged(cart);
+	auto frame = std::make_unique<FrameBuffer>();
+	Debugger debugger(debugged);
+	for (int i = 0; i < 3; ++i)
+	{
+		REQUIRE(plain.runFrame(*frame));
+	}
+	REQUIRE(debugger.runFrames(3));
+	REQUIRE(debugged.instructionCount() == plain.instructionCount());
+	REQUIRE(frameHash(debugger.picture()) == frameHash(*frame));
+}
+
+TEST_CASE("The debugger stops where the CPU halts", "[Debugger]")
+{
+	const NESCart cart = nromCart({0xe8, 0xe8, 0x02, 0xe8}); // INX, INX, JAM, INX
+	NES nes(cart);
+	Debugger debugger(nes);
+
+	REQUIRE(debugger.step(2));
+	REQUIRE_FALSE(debugger.halted());
+	REQUIRE_FALSE(debugger.step(5));
+	REQUIRE(debugger.halted());
+	REQUIRE(nes.cpuState().pc.value == 0x8002);
+	REQUIRE(nes.cpuState().x == 2);
+	REQUIRE_FALSE(debugger.runFrames());
+	REQUIRE(nes.cpuState().x == 2);
+}
+
+TEST_CASE("Indirect stores don't trip read watchpoints on their target", "[Debugger]")
+{
+	const NESCart cart = nromCart({
+		0xa9, 0x00, 0x85, 0x10, // LDA #$00, STA $10
+		0xa9, 0x03, 0x85, 0x11, // LDA #$03, STA $11
+		0xa2, 0x00, 0xa0, 0x00, // LDX #0, LDY #0
+		0xa9, 0x42, // LDA #$42
+		0x81, 0x10, // STA ($10,X)
+		0x91, 0x10, // STA ($10),Y
+		0xa1, 0x10, // LDA ($10,X)
+		0x4c, 0x14, 0x80 // JMP $8014
+	});
+	NES nes(cart);
+	Debugger debugger(nes);
+	debugger.setBreakpoint(mos6502::Breakpoints::Read, 0x0300);
+
+	REQUIRE(debugger.step(9));
+	REQUIRE(nes.ram()[0x300] == 0x42);
+	REQUIRE_FALSE(debugger.step());
+	REQUIRE(debugger.getBreakpoints().stoppedBy() == mos6502::Breakpoints::Read);
+	REQUIRE(nes.cpuState().pc.value == 0x8014);
+}
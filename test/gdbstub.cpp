@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "catch.hpp"
+
+#include "../src/gdbstub.hpp"
+#include "testcarts.hpp"
+
+// the client end, sending a packet and returning the reply's data
+class GdbClient
+{
+	int socket;
+
+public:
+	GdbClient(int port) : socket(::socket(AF_INET, SOCK_STREAM, 0))
+	{
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = htons(port);
+		connect(socket, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+	}
+
+	~GdbClient()
+	{
+		close(socket);
+	}
+
+	std::string request(const std::string &data)
+	{
+		unsigned sum = 0;
+		for (char c : data)
+		{
+			sum += static_cast<unsigned char>(c);
+		}
+		char checksum[3];
+		snprintf(checksum, sizeof(checksum), "%02x", sum & 0xff);
+		const std::string packet = "$" + data + "#" + checksum;
+		send(socket, packet.data(), packet.size(), 0);
+
+		std::string received;
+		char c;
+		while (recv(socket, &c, 1, 0) == 1)
+		{
+			received += c;
+			const size_t end = received.find('#');
+			if (end != std::string::npos && received.size() == end + 3)
+			{
+				const size_t start = received.find('$');
+				send(socket, "+", 1, 0);
+				return received.substr(start + 1, end - start - 1);
+			}
+		}
+		return "connection closed";
+	}
+};
+
+TEST_CASE("GDB can inspect and change the machine and stop it at breakpoints", "[GdbStub]")
+{
+	const NESCart cart = countingCart();
+	NES nes(cart);
+	nes.setButtons(0, NESController::A);
+	Debugger debugger(nes);
+	GdbStub stub(debugger);
+	REQUIRE(stub.listen(0));
+	std::thread server([&stub] { stub.serve(); });
+
+	{
+		GdbClient gdb(stub.port());
+		REQUIRE(gdb.request("qSupported:multiprocess+").find("qXfer:features:read+") != std::string::npos);
+		REQUIRE(gdb.request("qXfer:features:read:target.xml:0,1000").compare(0, 6, "l<?xml") == 0);
+		REQUIRE(gdb.request("?") == "S05");
+		REQUIRE(gdb.request("g") == "00000024fd0080");
+		REQUIRE(gdb.request("m8000,2") == "a901");
+
+		REQUIRE(gdb.request("Z0,8011,1") == "OK");
+		REQUIRE(gdb.request("c") == "S05");
+		REQUIRE(gdb.request("p5") == "1180");
+		REQUIRE(gdb.request("s") == "S05");
+		REQUIRE(gdb.request("p5") == "1380");
+		REQUIRE(gdb.request("m0,1") == "01");
+		REQUIRE(gdb.request("z0,8011,1") == "OK");
+
+		REQUIRE(gdb.request("Z2,0,1") == "OK");
+		REQUIRE(gdb.request("c") == "T05watch:0000;");
+		REQUIRE(gdb.request("m0,1") == "02");
+		REQUIRE(gdb.request("z2,0,1") == "OK");
+
+		REQUIRE(gdb.request("M10,2:abcd") == "OK");
+		REQUIRE(gdb.request("m10,2") == "abcd");
+		REQUIRE(gdb.request("P0=42") == "OK");
+		REQUIRE(gdb.request("p0") == "42");
+		REQUIRE(gdb.request("vMustReplyEmpty") == "");
+		REQUIRE(gdb.request("D") == "OK");
+	}
+	server.join();
+	REQUIRE(nes.cpuState().a == 0x42);
+	REQUIRE(nes.ram()[0x11] == 0xcd);
+}
+
+TEST_CASE("GDB sees a halted CPU stop with SIGILL", "[GdbStub]")
+{
+	const NESCart cart = nromCart({0xe8, 0x02}); // INX, JAM
+	NES nes(cart);
+	Debugger debugger(nes);
+	GdbStub stub(debugger);
+	REQUIRE(stub.listen(0));
+	std::thread server([&stub] { stub.serve(); });
+
+	{
+		GdbClient gdb(stub.port());
+		REQUIRE(gdb.request("s") == "S05");
+		REQUIRE(gdb.request("c") == "S04");
+		REQUIRE(gdb.request("p5") == "0180");
+		REQUIRE(gdb.request("?") == "S04");
+		REQUIRE(gdb.request("D") == "OK");
+	}
+	server.join();
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "catch.hpp"
+
+#include "../src/movie.hpp"
+#include "../src/movieplayer.hpp"
+#include "testcarts.hpp"
+
+TEST_CASE("Movies read FCEUX's FM2 text", "[Movie]")
+{
+	const std::string path = "movie_test.fm2";
+	{
+		std::ofstream file(path);
+		file << "version 3\r\n"
+			 << "emuVersion 22020\r\n"
+			 << "palFlag 0\r\n"
+			 << "romFilename Some Game\r\n"
+			 << "romChecksum base64:AAAAAAAAAAAAAAAAAAAAAA==\r\n"
+			 << "fourscore 0\r\n"
+			 << "port0 1\r\n"
+			 << "port1 0\r\n"
+			 << "port2 0\r\n"
+			 << "|2|........|||\r\n"
+			 << "|0|R......A|||\r\n"
+			 << "|0|...U.S..|.L......||\r\n";
+	}
+	Movie movie;
+	REQUIRE(movie.read(path));
+	REQUIRE(movie.romFilename == "Some Game");
+	REQUIRE_FALSE(movie.pal);
+	REQUIRE(movie.frames.size() == 3);
+	REQUIRE(movie.frames[0].commands == Movie::HardReset);
+	REQUIRE(movie.frames[0].buttons[0] == 0);
+	REQUIRE(movie.frames[1].buttons[0] == (NESController::Right | NESController::A));
+	REQUIRE(movie.frames[2].buttons[0] == (NESController::Up | NESController::Select));
+	REQUIRE(movie.frames[2].buttons[1] == NESController::Left);
+
+	// written and read back unchanged
+	movie.pal = true;
+	REQUIRE(movie.write(path));
+	Movie again;
+	REQUIRE(again.read(path));
+	REQUIRE(again.pal);
+	REQUIRE(again.romFilename == movie.romFilename);
+	REQUIRE(again.frames.size() == movie.frames.size());
+	for (size_t i = 0; i < movie.frames.size(); ++i)
+	{
+		REQUIRE(again.frames[i].commands == movie.frames[i].commands);
+		REQUIRE(again.frames[i].buttons == movie.frames[i].buttons);
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Movies for other input devices are refused", "[Movie]")
+{
+	const std::string path = "movie_test.fm2";
+	{
+		std::ofstream file(path);
+		file << "version 3\nfourscore 1\n|0|........|........|........|........||\n";
+	}
+	Movie movie;
+	REQUIRE_FALSE(movie.read(path));
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Movies with commands that aren't a number are refused", "[Movie]")
+{
+	const std::string path = "movie_test.fm2";
+	for (const char *commands : {"x", "1x", "-1", "256", "99999999999"})
+	{
+		{
+			std::ofstream file(path);
+			file << "version 3\n|0|........|||\n|" << commands << "|........|||\n";
+		}
+		Movie movie;
+		REQUIRE_FALSE(movie.read(path));
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("A recorded run replays to the same hashes every frame", "[Movie]")
+{
+	// recorded the way nesebar does it, input latched once a frame
+	const NESCart cart = countingCart();
+	Movie recording;
+	recording.romFilename = "counting.nes";
+	std::ostringstream recorded;
+	auto nes = std::make_unique<NES>(cart);
+	auto frame = std::make_unique<FrameBuffer>();
+	for (long i = 0; i < 30; ++i)
+	{
+		const byte buttons = (i % 7 < 3 ? NESController::A : 0) | (i % 5 == 0 ? NESController::Start : 0);
+		const Movie::Frame input = {0, {buttons, static_cast<byte>(i % 3 ? 0 : NESController::B)}};
+		nes->setButtons(0, input.buttons[0]);
+		nes->setButtons(1, input.buttons[1]);
+		recording.frames.push_back(input);
+		nes->runFrame(*frame);
+		writeFrameHashes(recorded, i, *nes, *frame);
+	}
+	REQUIRE(nes->peek(0x0000) != 0);
+
+	const std::string path = "movie_test.fm2";
+	REQUIRE(recording.write(path));
+	Movie movie;
+	REQUIRE(movie.read(path));
+	std::remove(path.c_str());
+	REQUIRE(movie.frames.size() == recording.frames.size());
+
+	std::ostringstream replayed;
+	playMovie(cart, movie, movie.frames.size(), [&](long i, const NES &nes, const FrameBuffer &frame) {
+		writeFrameHashes(replayed, i, nes, frame);
+	});
+	const std::string hashes = recorded.str();
+	REQUIRE(replayed.str() == hashes);
+	REQUIRE(std::count(hashes.begin(), hashes.end(), '\n') == 30);
+
+	// a hard reset powers the machine on again
+	movie.frames[10].commands = Movie::HardReset;
+	std::ostringstream reset;
+	playMovie(cart, movie, movie.frames.size(), [&](long i, const NES &nes, const FrameBuffer &frame) {
+		writeFrameHashes(reset, i, nes, frame);
+	});
+	REQUIRE(reset.str() != hashes);
+	REQUIRE(reset.str().substr(0, 200) == hashes.substr(0, 200));
+}
@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <zlib.h>
+#include "catch.hpp"
+
+#include "../src/nescart.hpp"
+#include "../src/romdb.hpp"
+#include "testcarts.hpp"
+
+// a ROM image with the given header bytes 4-15 and zeroed PRG/CHR data
+TEST_CASE("iNES 1.0 headers", "[NESCart]")
+{
+	// NROM-256, vertical mirroring
+	NESCart cart = loadCart(romImage({2, 1, 0x01, 0x00}, 2 * prgRomPageSize + chrRomPageSize));
+	REQUIRE_FALSE(cart.nes2);
+	REQUIRE(cart.mapper == 0);
+	REQUIRE(cart.prgRom.size() == 2 * prgRomPageSize);
+	REQUIRE(cart.chrRom.size() == chrRomPageSize);
+	REQUIRE(cart.chrRamBytes == 0);
+	REQUIRE(cart.prgRamBytes == prgRamPageSize);
+	REQUIRE(cart.prgNvramBytes == 0);
+	REQUIRE(cart.timing == Timing::NTSC);
+	REQUIRE(cart.mirroring() == Mirroring::Vertical);
+
+	// MMC1 with battery backed PRG-RAM and CHR-RAM, PAL
+	cart = loadCart(romImage({8, 0, 0x12, 0x00, 0, 0x01}, 8 * prgRomPageSize));
+	REQUIRE(cart.mapper == 1);
+	REQUIRE(cart.chrRom.empty());
+	REQUIRE(cart.chrRamBytes == chrRomPageSize);
+	REQUIRE(cart.prgRamBytes == 0);
+	REQUIRE(cart.prgNvramBytes == prgRamPageSize);
+	REQUIRE(cart.timing == Timing::PAL);
+	REQUIRE(cart.mirroring() == Mirroring::Horizontal);
+
+	// four screen VRAM overrides the mirroring bit
+	cart = loadCart(romImage({1, 1, 0x09, 0x00}, prgRomPageSize + chrRomPageSize));
+	REQUIRE(cart.mirroring() == Mirroring::FourScreen);
+}
+
+TEST_CASE("iNES 1.0 headers with junk padding", "[NESCart]")
+{
+	// "DiskDude!" in bytes 7-15, the upper mapper nibble can't be trusted
+	NESCart cart = loadCart(romImage({1, 1, 0x40, 'D', 'i', 's', 'k', 'D', 'u', 'd', 'e', '!'}, prgRomPageSize + chrRomPageSize));
+	REQUIRE_FALSE(cart.nes2);
+	REQUIRE(cart.mapper == 4);
+
+	cart = loadCart(romImage({1, 1, 0x40, 0x10}, prgRomPageSize + chrRomPageSize));
+	REQUIRE(cart.mapper == 0x14);
+}
+
+TEST_CASE("NES 2.0 mapper, submapper and RAM sizes", "[NESCart]")
+{
+	// mapper 0x1a4 submapper 3, 8K PRG-RAM, 32K PRG-NVRAM, 8K CHR-RAM, 2K CHR-NVRAM, Dendy
+	NESCart cart = loadCart(romImage({2, 0, 0x41, 0xa8, 0x31, 0x00, 0x97, 0x57, 0x03}, 2 * prgRomPageSize));
+	REQUIRE(cart.nes2);
+	REQUIRE(cart.mapper == 0x1a4);
+	REQUIRE(cart.submapper == 3);
+	REQUIRE(cart.prgRom.size() == 2 * prgRomPageSize);
+	REQUIRE(cart.chrRom.empty());
+	REQUIRE(cart.prgRamBytes == 8192);
+	REQUIRE(cart.prgNvramBytes == 32768);
+	REQUIRE(cart.chrRamBytes == 8192);
+	REQUIRE(cart.chrNvramBytes == 2048);
+	REQUIRE(cart.timing == Timing::Dendy);
+
+	// no RAM at all is allowed
+	cart = loadCart(romImage({1, 1, 0x00, 0x08}, prgRomPageSize + chrRomPageSize));
+	REQUIRE(cart.nes2);
+	REQUIRE(cart.prgRamBytes == 0);
+	REQUIRE(cart.prgNvramBytes == 0);
+	REQUIRE(cart.chrRamBytes == 0);
+
+	cart = loadCart(romImage({1, 1, 0x00, 0x08, 0, 0, 0, 0, 0x01}, prgRomPageSize + chrRomPageSize));
+	REQUIRE(cart.timing == Timing::PAL);
+	cart = loadCart(romImage({1, 1, 0x00, 0x08, 0, 0, 0, 0, 0x02}, prgRomPageSize + chrRomPageSize));
+	REQUIRE(cart.timing == Timing::MultiRegion);
+}
+
+TEST_CASE("NES 2.0 ROM sizes", "[NESCart]")
+{
+	// upper size bits in byte 9: 0x102 PRG pages, 0x201 CHR pages
+	std::istringstream large(romImage({0x02, 0x01, 0x00, 0x08, 0x00, 0x21}, 0));
+	NESCart cart(large);
+	REQUIRE(cart.prgRom.size() == 0x102 * prgRomPageSize);
+	REQUIRE(cart.chrRom.size() == 0x201 * chrRomPageSize);
+
+	// exponent-multiplier notation: 2^5 * 3 bytes of PRG, 2^10 * 1 of CHR
+	cart = loadCart(romImage({(5 << 2) | 1, (10 << 2) | 0, 0x00, 0x08, 0x00, 0xff}, 96 + 1024));
+	REQUIRE(cart.prgRom.size() == 96);
+	REQUIRE(cart.chrRom.size() == 1024);
+}
+
+TEST_CASE("Gzipped ROMs load the same as plain ones", "[NESCart]")
+{
+	std::string image = romImage({2, 1, 0x01, 0x00}, 2 * prgRomPageSize + chrRomPageSize);
+	for (size_t i = 16; i < image.size(); ++i)
+	{
+		image[i] = static_cast<char>(i * 7);
+	}
+
+	const std::string path = "nescart_test.nes.gz";
+	gzFile file = gzopen(path.c_str(), "wb");
+	REQUIRE(file != nullptr);
+	REQUIRE(gzwrite(file, image.data(), image.size()) == static_cast<int>(image.size()));
+	gzclose(file);
+
+	std::istringstream plainImage(image);
+	NESCart plain(plainImage);
+	NESCart gzipped(path);
+	std::remove(path.c_str());
+	REQUIRE(gzipped.prgRom == plain.prgRom);
+	REQUIRE(gzipped.chrRom == plain.chrRom);
+	REQUIRE(gzipped.crc == plain.crc);
+}
+
+TEST_CASE("ROM database lookups", "[NESCart]")
+{
+	const RomDbEntry table[] = {
+		{0x00000001, 1, 0, RomMirroring::Header, false, Timing::NTSC},
+		{0x3337ec46, 0, 0, RomMirroring::Vertical, false, Timing::NTSC},
+		{0xfffffffe, 4, 1, RomMirroring::FourScreen, true, Timing::PAL},
+	};
+	const RomDbEntry *end = table + 3;
+	REQUIRE(findRom(0x00000001, table, end) == &table[0]);
+	REQUIRE(findRom(0x3337ec46, table, end) == &table[1]);
+	REQUIRE(findRom(0xfffffffe, table, end) == &table[2]);
+	REQUIRE(findRom(0x00000000, table, end) == nullptr);
+	REQUIRE(findRom(0x3337ec47, table, end) == nullptr);
+	REQUIRE(findRom(0xffffffff, table, end) == nullptr);
+	REQUIRE(findRom(0x3337ec46, table, table) == nullptr);
+}
+
+TEST_CASE("ROM database entries correct iNES 1.0 headers", "[NESCart]")
+{
+	// NROM, horizontal, no battery, as far as the header knows
+	NESCart cart = loadCart(romImage({1, 1, 0x00, 0x00}, prgRomPageSize + chrRomPageSize));
+	REQUIRE(cart.mapper == 0);
+	REQUIRE(cart.prgRamBytes == prgRamPageSize);
+
+	const RomDbEntry entry = {cart.crc, 1, 5, RomMirroring::Vertical, true, Timing::PAL};
+	REQUIRE(findRom(cart.crc, &entry, &entry + 1) == &entry);
+	cart.applyRomDatabase(entry);
+	REQUIRE(cart.mapper == 1);
+	REQUIRE(cart.submapper == 5);
+	REQUIRE(cart.mirroring() == Mirroring::Vertical);
+	REQUIRE(cart.timing == Timing::PAL);
+	REQUIRE(cart.prgRamBytes == 0);
+	REQUIRE(cart.prgNvramBytes == prgRamPageSize);
+	REQUIRE((cart.header.flag6 & (1 << flag6SRAMBattery)));
+
+	// four screen wins over the header's mirroring bit, and Header keeps it
+	cart.applyRomDatabase({cart.crc, 1, 0, RomMirroring::FourScreen, false, Timing::NTSC});
+	REQUIRE(cart.mirroring() == Mirroring::FourScreen);
+	REQUIRE(cart.prgRamBytes == prgRamPageSize);
+	REQUIRE(cart.prgNvramBytes == 0);
+	cart.applyRomDatabase({cart.crc, 1, 0, RomMirroring::Header, false, Timing::NTSC});
+	REQUIRE(cart.mirroring() == Mirroring::FourScreen);
+	cart.applyRomDatabase({cart.crc, 1, 0, RomMirroring::Horizontal, false, Timing::NTSC});
+	REQUIRE(cart.mirroring() == Mirroring::Horizontal);
+}
@@ -0,0 +1,42 @@
+#include "catch.hpp"
+
+#include "../src/nescontroller.hpp"
+
+TEST_CASE("Controller shifts out buttons after a strobe", "[NESController]")
+{
+	NESController controller;
+	controller.setButtons(NESController::A | NESController::Start | NESController::Right);
+	controller.write(1);
+	REQUIRE(controller.read() == 0x41); // A again and again while strobed
+	REQUIRE(controller.read() == 0x41);
+	controller.write(0);
+
+	const byte expected[] = {1, 0, 0, 1, 0, 0, 0, 1, 1, 1};
+	for (byte bit : expected)
+	{
+		REQUIRE(controller.read() == (0x40 | bit));
+	}
+
+	// buttons pressed after the strobe aren't seen until the next one
+	controller.setButtons(NESController::B);
+	REQUIRE(controller.read() == 0x41);
+	controller.write(1);
+	controller.write(0);
+	REQUIRE(controller.read() == 0x40);
+	REQUIRE(controller.read() == 0x41);
+}
+
+TEST_CASE("Controller buttons from RLDUTSBA notation", "[NESController]")
+{
+	REQUIRE(NESController::parseButtons("........") == 0);
+	REQUIRE(NESController::parseButtons("R......A") == (NESController::Right | NESController::A));
+	REQUIRE(NESController::parseButtons("   UT   ") == (NESController::Up | NESController::Start));
+	REQUIRE(NESController::parseButtons("") == 0);
+}
+
+TEST_CASE("Buttons format in RLDUTSBA notation", "[NESController]")
+{
+	REQUIRE(NESController::formatButtons(0) == "........");
+	REQUIRE(NESController::formatButtons(NESController::Right | NESController::B) == "R.....B.");
+	REQUIRE(NESController::parseButtons(NESController::formatButtons(0xa5)) == 0xa5);
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <memory>
+#include <string>
+#include "catch.hpp"
+
+#include "../src/cowmemory.hpp"
+#include "../src/nes.hpp"
+#include "testcarts.hpp"
+
+TEST_CASE("Copies share pages until they write them", "[CowMemory]")
+{
+	CowMemory<16> memory(40);
+	REQUIRE(memory.size() == 48);
+	REQUIRE(memory[39] == 0);
+
+	memory.write(20, 1);
+	CowMemory<16> copy(memory);
+	REQUIRE(copy.page(1) == memory.page(1));
+	REQUIRE(copy[20] == 1);
+
+	copy.write(21, 2);
+	REQUIRE(copy.page(1) != memory.page(1));
+	REQUIRE(copy.page(0) == memory.page(0));
+	REQUIRE(copy[20] == 1);
+	REQUIRE(copy[21] == 2);
+	REQUIRE(memory[21] == 0);
+
+	memory.write(0, 3);
+	REQUIRE(copy[0] == 0);
+	REQUIRE(memory[0] == 3);
+}
+
+TEST_CASE("A forked NES carries on like its parent without touching it", "[NES]")
+{
+	const NESCart cart = countingCart();
+	auto frame = std::make_unique<FrameBuffer>();
+	auto parent = std::make_unique<NES>(cart);
+	auto reference = std::make_unique<NES>(cart);
+	auto released = std::make_unique<NES>(cart);
+	parent->setButtons(0, NESController::A);
+	reference->setButtons(0, NESController::A);
+	released->setButtons(0, NESController::A);
+	for (int i = 0; i < 3; ++i)
+	{
+		parent->runFrame(*frame);
+		reference->runFrame(*frame);
+		released->runFrame(*frame);
+	}
+
+	auto fork = parent->fork();
+	REQUIRE(fork->ram()[0] == parent->ram()[0]);
+	REQUIRE(fork->cpuState().pc.value == parent->cpuState().pc.value);
+	REQUIRE(fork->instructionCount() == parent->instructionCount());
+
+	// same input, same machine
+	auto forkFrame = std::make_unique<FrameBuffer>();
+	parent->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	reference->runFrame(*frame);
+	released->runFrame(*frame);
+	REQUIRE(fork->ram()[0] == parent->ram()[0]);
+	REQUIRE(fork->instructionCount() == parent->instructionCount());
+	REQUIRE(frameHash(*forkFrame) == frameHash(*frame));
+
+	// the fork's writes stay its own, and the parent's
+	parent->setButtons(0, 0);
+	released->setButtons(0, 0);
+	parent->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	reference->runFrame(*frame);
+	released->runFrame(*frame);
+	REQUIRE(parent->ram()[0] == released->ram()[0]);
+	REQUIRE(reference->ram()[0] != released->ram()[0]);
+	REQUIRE(fork->ram()[0] == reference->ram()[0]);
+	REQUIRE(fork->instructionCount() == reference->instructionCount());
+
+	// and the fork outlives the parent
+	parent.reset();
+	fork->runFrame(*forkFrame);
+	reference->runFrame(*frame);
+	REQUIRE(fork->ram()[0] == reference->ram()[0]);
+}
+
+// writes count bytes of value to PPU address with rendering off, leaving
+// the address at 0 and background rendering on
+static void writeVram(NES &nes, uint16_t address, byte value, int count)
+{
+	nes.poke(0x2001, 0x00);
+	nes.poke(0x2006, address >> 8);
+	nes.poke(0x2006, address & 0xff);
+	for (int i = 0; i < count; ++i)
+	{
+		nes.poke(0x2007, value);
+	}
+	nes.poke(0x2006, 0x00);
+	nes.poke(0x2006, 0x00);
+	nes.poke(0x2001, 0x0a);
+}
+
+static bool filledWith(const FrameBuffer &frame, byte pixel)
+{
+	return std::all_of(frame.pixels.begin(), frame.pixels.end(), [pixel](byte p) { return p == pixel; });
+}
+
+TEST_CASE("A fork writes CHR-RAM without touching its parent's tiles", "[NES]")
+{
+	// every tile on screen is tile 0, drawn through background palette 0
+	const NESCart cart = nromCart({0x4c, 0x00, 0x80}, true); // JMP $8000
+	auto parent = std::make_unique<NES>(cart);
+	auto frame = std::make_unique<FrameBuffer>();
+	parent->runFrame(*frame);
+	const byte colors[] = {0x0f, 0x30, 0x16, 0x27};
+	for (int i = 0; i < 4; ++i)
+	{
+		writeVram(*parent, 0x3f00 + i, colors[i], 1);
+	}
+	writeVram(*parent, 0x0000, 0xff, 16); // tile 0 in color 3
+	parent->runFrame(*frame);
+	parent->runFrame(*frame);
+	REQUIRE(filledWith(*frame, colors[3]));
+
+	// the parent takes tile 0 to color 1 and the fork to color 2, both
+	// writing the page they share and the decoded tiles they share
+	auto fork = parent->fork();
+	writeVram(*parent, 0x0008, 0x00, 8);
+	writeVram(*fork, 0x0000, 0x00, 8);
+	auto forkFrame = std::make_unique<FrameBuffer>();
+	parent->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	parent->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	REQUIRE(filledWith(*frame, colors[1]));
+	REQUIRE(filledWith(*forkFrame, colors[2]));
+
+	// and once they own their pages, writes still reach only their own
+	writeVram(*fork, 0x0008, 0x00, 8);
+	parent->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	parent->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	REQUIRE(filledWith(*frame, colors[1]));
+	REQUIRE(filledWith(*forkFrame, colors[0]));
+
+	// a fork of the fork draws a tile from another 1K bank through its own
+	// nametable, which the fork it came from never sees
+	auto second = fork->fork();
+	writeVram(*second, 0x0400, 0xff, 8);
+	writeVram(*second, 0x2000, 0x40, 0x3c0); // the nametable to tile $40
+	second->runFrame(*frame);
+	second->runFrame(*frame);
+	fork->runFrame(*forkFrame);
+	REQUIRE(filledWith(*frame, colors[1]));
+	REQUIRE(filledWith(*forkFrame, colors[0]));
+}
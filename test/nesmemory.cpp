@@ -1,6 +1,22 @@
+#include <vector>
 #include "catch.hpp"
 
 #include "../src/nesmemory.hpp"
+#include "testcarts.hpp"
+
+// a cart's memory map, with the PPU and APU it reaches
+struct MemoryFixture
+{
+	const NESCart cart;
+	NESPPU ppu;
+	NESAPU apu;
+	NESMemory memory;
+
+	explicit MemoryFixture(const NESCart &cart)
+		: cart(cart), ppu(this->cart), apu(NESAPU::clockRate(this->cart.timing)), memory(this->cart, ppu, apu)
+	{
+	}
+};
 
 TEST_CASE("NES Memory Read/Write", "[NESMemory]")
 {
@@ -10,3 +26,59 @@ TEST_CASE("NES Memory Read/Write", "[NESMemory]")
 	//mem.memWrite(0x0810, 21);
 	//REQUIRE(mem.memRead(0x0010) == 21);
 }
+
+TEST_CASE("NES Memory maps RAM and the cart's PRG-ROM", "[NESMemory]")
+{
+	std::vector<byte> prg(prgRomPageSize, 0);
+	prg[0] = 0x12;
+	prg[0x3fff] = 0x34;
+	MemoryFixture fixture(nromCart(prg));
+	NESMemory &memory = fixture.memory;
+
+	memory.write(0x0810, 21);
+	REQUIRE(memory.read(0x0010) == 21);
+	REQUIRE(memory.read(0x1810) == 21);
+	REQUIRE(memory.ram()[0x10] == 21);
+
+	// 16K of PRG-ROM is mirrored at $C000 and can't be written
+	REQUIRE(memory.read(0x8000) == 0x12);
+	REQUIRE(memory.read(0xc000) == 0x12);
+	REQUIRE(memory.peek(0xffff) == 0x34);
+	memory.write(0x8000, 0);
+	REQUIRE(memory.read(0xc000) == 0x12);
+	REQUIRE(memory.pageData(0xc0)[0] == 0x12);
+	REQUIRE(memory.pageData(0x07) == memory.ram() + 0x700);
+}
+
+TEST_CASE("NES Memory leaves unmapped addresses alone", "[NESMemory]")
+{
+	// NES 2.0 with no PRG-RAM, so nothing answers at $4020-$7FFF
+	MemoryFixture fixture(nromCart({}, false, {0x00, 0x08}));
+	REQUIRE(fixture.cart.prgRamBytes + fixture.cart.prgNvramBytes == 0);
+	NESMemory &memory = fixture.memory;
+
+	memory.write(0x0000, 0x55);
+	for (uint16_t address : {0x4020, 0x5000, 0x5fff, 0x6000, 0x7fff})
+	{
+		memory.write(address, 0x99);
+		REQUIRE(memory.read(address) == 0);
+		REQUIRE(memory.peek(address) == 0);
+	}
+	REQUIRE(memory.ram()[0] == 0x55);
+	REQUIRE(memory.read(0x0000) == 0x55);
+	REQUIRE(memory.pageData(0x50) == nullptr);
+	REQUIRE(memory.pageData(0x60) == nullptr);
+}
+
+TEST_CASE("NES Memory maps PRG-RAM at $6000", "[NESMemory]")
+{
+	MemoryFixture fixture(nromCart({}));
+	NESMemory &memory = fixture.memory;
+
+	memory.write(0x6000, 0x99);
+	memory.write(0x7fff, 0x42);
+	REQUIRE(memory.read(0x6000) == 0x99);
+	REQUIRE(memory.peek(0x7fff) == 0x42);
+	REQUIRE(memory.ram()[0] == 0);
+	REQUIRE(memory.read(0x5000) == 0);
+}
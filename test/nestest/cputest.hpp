@@ -0,0 +1,345 @@
+#ifndef CPUTEST_H
+#define CPUTEST_H
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../src/opcodelist.hpp"
+
+// Builds cputest, an NROM image standing in for nestest.nes where that can't
+// be shipped. From $C000 it runs every opcode the core implements, official
+// and not, a couple of times over with random registers, flags and operands,
+// then sums RAM so stores show up in the log too, and ends in a loop.
+// cputest.log is this program's trace from a known good build.
+//
+// Operands only ever reach RAM: $00-$3F holds pointers into $0200-$06FF,
+// zero page data is $40-$FF and absolute data is $0200-$07FF, so no
+// instruction touches an I/O register or the pointers.
+
+namespace cputest
+{
+	using mos6502::Addressing::Mode;
+
+	constexpr uint16_t start = 0xc000;
+	constexpr uint16_t pointers = 0x40; // bytes of pointers at $00
+	constexpr uint16_t branchSpots = 0xf0fc; // where branches cross a page, one page each
+	constexpr uint16_t handlers = 0xff00; // RTI for interrupts, then RTS for JSR
+	constexpr int rounds = 2;
+
+	enum Opcode : byte
+	{
+		BRK = 0x00,
+		PHA = 0x48,
+		JMP = 0x4c,
+		PLP = 0x28,
+		RTS = 0x60,
+		RTI = 0x40,
+		JSR = 0x20,
+		JMPIndirect = 0x6c,
+		ADCAbsoluteX = 0x7d,
+		STAAbsolute = 0x8d,
+		STAZeroPage = 0x85,
+		LDAImmediate = 0xa9,
+		LDXImmediate = 0xa2,
+		LDYImmediate = 0xa0,
+		CLC = 0x18,
+		TXA = 0x8a,
+		INX = 0xe8,
+		BNE = 0xd0
+	};
+
+	class Program
+	{
+		std::vector<byte> prg;
+		uint16_t pc = start;
+		uint32_t seed = 0x6502;
+
+	public:
+		Program() : prg(0x4000, 0xea) {}
+
+		uint16_t here() const { return pc; }
+		void org(uint16_t address) { pc = address; }
+
+		void emit(byte value)
+		{
+			assert(pc >= start);
+			prg[pc - start] = value;
+			++pc;
+		}
+
+		void emit(byte opcode, byte operand)
+		{
+			emit(opcode);
+			emit(operand);
+		}
+
+		void emit16(byte opcode, uint16_t operand)
+		{
+			emit(opcode);
+			emit(operand & 0xff);
+			emit(operand >> 8);
+		}
+
+		// an LDA # whose operand gets filled in later, returning where
+		uint16_t emitPlaceholder()
+		{
+			emit(LDAImmediate, 0);
+			return pc - 1;
+		}
+
+		void patch(uint16_t address, byte value) { prg[address - start] = value; }
+
+		byte random()
+		{
+			seed = seed * 1664525 + 1013904223;
+			return seed >> 24;
+		}
+
+		// a random value from first to last inclusive
+		int random(int first, int last)
+		{
+			const int value = (random() << 8) | random();
+			return first + value % (last - first + 1);
+		}
+
+		const std::vector<byte> &rom() const { return prg; }
+	};
+
+	// random registers, and random flags through the stack
+	inline void setRegisters(Program &program, byte &x, byte &y)
+	{
+		x = program.random();
+		y = program.random();
+		program.emit(LDXImmediate, x);
+		program.emit(LDYImmediate, y);
+		program.emit(LDAImmediate, program.random());
+		program.emit(PHA);
+		program.emit(LDAImmediate, program.random());
+		program.emit(PLP);
+	}
+
+	inline void setRegisters(Program &program)
+	{
+		byte x, y;
+		setRegisters(program, x, y);
+	}
+
+	// pushes an address that's filled in later, high byte at high
+	inline void pushPlaceholder(Program &program, uint16_t &high, uint16_t &low)
+	{
+		high = program.emitPlaceholder();
+		program.emit(PHA);
+		low = program.emitPlaceholder();
+		program.emit(PHA);
+	}
+
+	// the instruction with operands that keep its accesses on the data,
+	// x and y being what setRegisters left in the last two LDs
+	inline void emitOperands(Program &program, const mos6502::OpcodeInfo &opcode, byte x, byte y)
+	{
+		switch (opcode.mode)
+		{
+			case Mode::Immediate:
+				program.emit(opcode.value, program.random());
+				break;
+			case Mode::ZeroPage:
+				program.emit(opcode.value, program.random(pointers, 0xff));
+				break;
+			case Mode::ZeroPageX:
+			case Mode::ZeroPageY:
+			{
+				const byte index = opcode.mode == Mode::ZeroPageX ? x : y;
+				program.emit(opcode.value, program.random(pointers, 0xff) - index);
+				break;
+			}
+			case Mode::Absolute:
+				program.emit16(opcode.value, program.random(0x0200, 0x07ff));
+				break;
+			case Mode::AbsoluteX:
+			case Mode::AbsoluteY:
+			{
+				const byte index = opcode.mode == Mode::AbsoluteX ? x : y;
+				program.emit16(opcode.value, program.random(0x0200, 0x07ff) - index);
+				break;
+			}
+			case Mode::IndexedIndirect:
+				program.emit(opcode.value, program.random(0, pointers / 2 - 1) * 2 - x);
+				break;
+			case Mode::IndirectIndexed:
+				program.emit(opcode.value, program.random(0, pointers / 2 - 1) * 2);
+				break;
+			default:
+				program.emit(opcode.value);
+				break;
+		}
+	}
+
+	// one run of the opcode, skipping two bytes of LDA #$EE wherever it
+	// jumps or branches
+	inline void emitTest(Program &program, const mos6502::OpcodeInfo &opcode, int round)
+	{
+		const byte skip = 0xee;
+		switch (opcode.value)
+		{
+			case BRK:
+			{
+				setRegisters(program);
+				program.emit(BRK, program.random());
+				return;
+			}
+			case JSR:
+			{
+				setRegisters(program);
+				program.emit16(JSR, handlers + 1);
+				return;
+			}
+			case RTS:
+			case RTI:
+			{
+				uint16_t high, low;
+				pushPlaceholder(program, high, low);
+				if (opcode.value == RTI)
+				{
+					program.emit(LDAImmediate, program.random());
+					program.emit(PHA);
+				}
+				setRegisters(program);
+				program.emit(opcode.value);
+				// RTS adds one to the address it pops, RTI doesn't
+				const uint16_t target = program.here() - (opcode.value == RTS);
+				program.patch(high, target >> 8);
+				program.patch(low, target & 0xff);
+				return;
+			}
+			case JMP:
+			{
+				setRegisters(program);
+				program.emit16(JMP, program.here() + 5);
+				program.emit(LDAImmediate, skip);
+				return;
+			}
+			case JMPIndirect:
+			{
+				// the second round has the pointer end a page, where the high
+				// byte comes from the start of that page rather than the next
+				const uint16_t pointer = round ? program.random(2, 7) * 0x100 + 0xff : program.random(0x0200, 0x07fe);
+				const uint16_t low = program.emitPlaceholder();
+				program.emit16(STAAbsolute, pointer);
+				const uint16_t high = program.emitPlaceholder();
+				program.emit16(STAAbsolute, round ? pointer & 0xff00 : pointer + 1);
+				setRegisters(program);
+				program.emit16(JMPIndirect, pointer);
+				program.emit(LDAImmediate, skip);
+				program.patch(low, program.here() & 0xff);
+				program.patch(high, program.here() >> 8);
+				return;
+			}
+		}
+
+		if (opcode.mode == Mode::Relative)
+		{
+			// the second round branches across a page at a spot of its own,
+			// landing on a jump back
+			setRegisters(program);
+			if (round)
+			{
+				const uint16_t spot = branchSpots + (opcode.value >> 5) * 0x100;
+				program.emit16(JMP, spot);
+				const uint16_t back = program.here();
+				program.org(spot);
+				program.emit(opcode.value, 2);
+				program.emit(LDAImmediate, skip);
+				program.emit16(JMP, back);
+				program.org(back);
+				return;
+			}
+			program.emit(opcode.value, 2);
+			program.emit(LDAImmediate, skip);
+			return;
+		}
+
+		byte x, y;
+		setRegisters(program, x, y);
+		emitOperands(program, opcode, x, y);
+	}
+
+	// returns the address of the loop the program ends in
+	inline uint16_t build(Program &program)
+	{
+		// no APU frame interrupts
+		program.emit(LDAImmediate, 0x40);
+		program.emit16(STAAbsolute, 0x4017);
+
+		// fill $0000-$07FF with something that isn't zeroes
+		program.emit(LDXImmediate, 0);
+		program.emit(LDAImmediate, 0xa5);
+		const uint16_t fill = program.here();
+		for (int page = 0; page < 8; ++page)
+		{
+			program.emit16(0x9d, page * 0x100); // STA abs,X
+		}
+		program.emit(0x69, 0x3b); // ADC #$3B
+		program.emit(0x2a); // ROL A
+		program.emit(INX);
+		program.emit(BNE, fill - program.here() - 2);
+
+		for (uint16_t pointer = 0; pointer < pointers; pointer += 2)
+		{
+			program.emit(LDAImmediate, program.random());
+			program.emit(STAZeroPage, pointer);
+			program.emit(LDAImmediate, program.random(2, 6));
+			program.emit(STAZeroPage, pointer + 1);
+		}
+
+		const std::vector<mos6502::OpcodeInfo> opcodes = mos6502::allOpcodes();
+		for (int round = 0; round < rounds; ++round)
+		{
+			for (const mos6502::OpcodeInfo &opcode : opcodes)
+			{
+				emitTest(program, opcode, round);
+			}
+		}
+
+		// sum RAM
+		program.emit(CLC);
+		program.emit(LDXImmediate, 0);
+		program.emit(TXA);
+		const uint16_t sum = program.here();
+		for (int page = 0; page < 8; ++page)
+		{
+			program.emit16(ADCAbsoluteX, page * 0x100);
+		}
+		program.emit(INX);
+		program.emit(BNE, sum - program.here() - 2);
+
+		const uint16_t end = program.here();
+		program.emit16(JMP, end);
+		assert(program.here() < branchSpots);
+
+		program.org(handlers);
+		program.emit(RTI);
+		program.emit(RTS);
+		program.org(0xfffa);
+		for (uint16_t vector : {handlers, start, handlers})
+		{
+			program.emit(vector & 0xff);
+			program.emit(vector >> 8);
+		}
+		return end;
+	}
+
+	// the iNES image, NROM-128 with CHR-RAM, and where it ends up looping
+	inline std::string image(uint16_t &end)
+	{
+		Program program;
+		end = build(program);
+		std::string rom = "NES\x1a\x01";
+		rom.resize(16, 0);
+		rom.append(program.rom().begin(), program.rom().end());
+		return rom;
+	}
+}
+
+#endif /* CPUTEST_H */
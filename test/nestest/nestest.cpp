@@ -0,0 +1,215 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../src/nes.hpp"
+#include "../../src/nescart.hpp"
+#include "cputest.hpp"
+
+// Runs nestest.nes in its automation mode, headless from $C000, and checks
+// the CPU state before every instruction against nestest.log. Stops at the
+// first line that differs. With --cputest it runs the generated program in
+// cputest.hpp against its own log instead, which --write records.
+
+namespace
+{
+	constexpr uint16_t automationStart = 0xc000;
+
+	struct LogLine
+	{
+		int number;
+		uint16_t pc;
+		int a, x, y, p, sp;
+		long cycles; // -1 for logs without CPU cycle counts
+		std::string text;
+	};
+
+	// reads the hex or decimal number after field, or returns false
+	bool readField(const std::string &text, const std::string &field, int base, long &value)
+	{
+		// past the PC, the rest of nestest.log's disassembly has no colons
+		const size_t at = text.find(field, 4);
+		if (at == std::string::npos)
+		{
+			return false;
+		}
+		try
+		{
+			value = std::stol(text.substr(at + field.size()), nullptr, base);
+		}
+		catch (const std::exception &)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	bool parseLine(const std::string &text, LogLine &line)
+	{
+		long pc, a, x, y, p, sp;
+		try
+		{
+			pc = std::stol(text.substr(0, 4), nullptr, 16);
+		}
+		catch (const std::exception &)
+		{
+			return false;
+		}
+		if (!readField(text, " A:", 16, a) || !readField(text, " X:", 16, x) || !readField(text, " Y:", 16, y)
+			|| !readField(text, " P:", 16, p) || !readField(text, " SP:", 16, sp))
+		{
+			return false;
+		}
+		// older logs put the PPU dot in CYC and the scanline in SL
+		if (text.find(" SL:") != std::string::npos || !readField(text, "CYC:", 10, line.cycles))
+		{
+			line.cycles = -1;
+		}
+		line.pc = pc;
+		line.a = a;
+		line.x = x;
+		line.y = y;
+		line.p = p;
+		line.sp = sp;
+		line.text = text;
+		return true;
+	}
+
+	void printState(std::ostream &out, const mos6502::State &state)
+	{
+		out << std::hex << std::uppercase << std::setfill('0')
+			<< std::setw(4) << state.pc.value
+			<< " A:" << std::setw(2) << static_cast<int>(state.a)
+			<< " X:" << std::setw(2) << static_cast<int>(state.x)
+			<< " Y:" << std::setw(2) << static_cast<int>(state.y)
+			<< " P:" << std::setw(2) << static_cast<int>(state.p)
+			<< " SP:" << std::setw(2) << static_cast<int>(state.sp)
+			<< std::dec << " CYC:" << state.totalCycles << std::endl;
+	}
+
+	bool matches(const LogLine &line, const mos6502::State &state)
+	{
+		return line.pc == state.pc.value && line.a == state.a && line.x == state.x && line.y == state.y
+			&& line.p == state.p && line.sp == state.sp && (line.cycles < 0 || line.cycles == state.totalCycles);
+	}
+
+	bool readLog(const char *path, std::vector<LogLine> &log)
+	{
+		std::ifstream logFile(path);
+		if (!logFile)
+		{
+			std::cerr << path << " not found" << std::endl;
+			return false;
+		}
+		std::string text;
+		for (int number = 1; std::getline(logFile, text); ++number)
+		{
+			LogLine line;
+			line.number = number;
+			if (!text.empty() && text.back() == '\r')
+			{
+				text.pop_back();
+			}
+			if (parseLine(text, line))
+			{
+				log.push_back(line);
+			}
+			else if (!text.empty())
+			{
+				std::cerr << path << ":" << number << ": can't read \"" << text << "\"" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// the cputest trace up to and including the loop it ends in
+	int writeLog(NES &nes, uint16_t end, const char *path)
+	{
+		std::ofstream logFile(path);
+		if (!logFile)
+		{
+			std::cerr << "Can't write " << path << std::endl;
+			return 1;
+		}
+		long lines = 1;
+		for (; nes.cpuState().pc.value != end; ++lines)
+		{
+			printState(logFile, nes.cpuState());
+			nes.run();
+		}
+		printState(logFile, nes.cpuState());
+		std::cout << "Wrote " << lines << " lines to " << path << std::endl;
+		return 0;
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	const bool cputest = argc > 1 && std::string(argv[1]) == "--cputest";
+	const bool write = cputest && argc > 3 && std::string(argv[3]) == "--write";
+	if (argc < 3)
+	{
+		std::cerr << "usage: " << argv[0] << " nestest.nes nestest.log" << std::endl
+				  << "       " << argv[0] << " --cputest cputest.log [--write]" << std::endl;
+		return 1;
+	}
+
+	std::unique_ptr<NESCart> cart;
+	uint16_t end = 0;
+	if (cputest)
+	{
+		std::istringstream image(cputest::image(end));
+		cart = std::make_unique<NESCart>(image);
+	}
+	else
+	{
+		if (!std::ifstream(argv[1]))
+		{
+			std::cerr << argv[1] << " not found" << std::endl;
+			return 1;
+		}
+		cart = std::make_unique<NESCart>(argv[1]);
+	}
+	auto nes = std::make_unique<NES>(*cart);
+	nes->jump(automationStart);
+	if (write)
+	{
+		return writeLog(*nes, end, argv[2]);
+	}
+
+	std::vector<LogLine> log;
+	if (!readLog(argv[2], log))
+	{
+		return 1;
+	}
+
+	for (const LogLine &line : log)
+	{
+		const mos6502::State &state = nes->cpuState();
+		if (!matches(line, state))
+		{
+			std::cout << "First divergence at line " << line.number << std::endl
+					  << "expected " << line.text << std::endl
+					  << "got      ";
+			printState(std::cout, state);
+			return 1;
+		}
+		nes->run();
+	}
+
+	// nestest leaves the number of the first failing test at $02 and $03
+	const int official = nes->peek(0x02), unofficial = nes->peek(0x03);
+	if (!cputest && (official || unofficial))
+	{
+		std::cout << std::hex << std::setfill('0') << "Test failure codes $02 = " << std::setw(2) << official
+				  << ", $03 = " << std::setw(2) << unofficial << std::endl;
+		return 1;
+	}
+	std::cout << (cputest ? "cputest" : "nestest") << " matched all " << log.size() << " lines" << std::endl;
+	return 0;
+}
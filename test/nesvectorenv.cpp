@@ -0,0 +1,80 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+
+#include "../src/nesvectorenv.hpp"
+#include "testcarts.hpp"
+
+TEST_CASE("Vector env steps every instance with its own action", "[NESVectorEnv]")
+{
+	const NESCart cart = countingCart();
+	NESVectorEnv env(cart, 3, NESVectorEnv::Observation::Ram);
+	REQUIRE(env.size() == 3);
+	REQUIRE(env.observationSize() == NES::ramSize);
+
+	std::vector<byte> observations(env.size() * env.observationSize());
+	const byte actions[] = {0, NESController::A, NESController::A | NESController::B};
+	env.step(actions, observations.data());
+
+	auto alone = std::make_unique<NES>(cart);
+	alone->setButtons(0, NESController::A);
+	auto frame = std::make_unique<FrameBuffer>();
+	alone->runFrame(*frame);
+
+	REQUIRE(observations[0] == 0);
+	REQUIRE(observations[env.observationSize()] == alone->ram()[0]);
+	REQUIRE(observations[env.observationSize()] != 0);
+	REQUIRE(observations[2 * env.observationSize()] == observations[env.observationSize()]);
+
+	// a reset instance starts again while the others carry on
+	env.reset(1);
+	env.step(actions, observations.data());
+	REQUIRE(observations[env.observationSize()] == alone->ram()[0]);
+	REQUIRE(observations[2 * env.observationSize()] != alone->ram()[0]);
+
+	// resetting one leaves the others alone
+	env.reset(2);
+	env.reset(1);
+	env.step(actions, observations.data());
+	REQUIRE(observations[0] == 0);
+	REQUIRE(observations[env.observationSize()] == alone->ram()[0]);
+	REQUIRE(observations[2 * env.observationSize()] == alone->ram()[0]);
+}
+
+TEST_CASE("Vector env frame observations", "[NESVectorEnv]")
+{
+	const NESCart cart = countingCart();
+	NESVectorEnv env(cart, 2, NESVectorEnv::Observation::Frame);
+	REQUIRE(env.observationSize() == screenWidth * screenHeight);
+
+	std::vector<byte> observations(env.size() * env.observationSize(), 0xff);
+	const byte actions[] = {0, 0};
+	env.step(actions, observations.data());
+
+	auto alone = std::make_unique<NES>(cart);
+	auto frame = std::make_unique<FrameBuffer>();
+	alone->runFrame(*frame);
+	for (int i = 0; i < env.size(); ++i)
+	{
+		REQUIRE(std::equal(frame->pixels.begin(), frame->pixels.end(), observations.begin() + i * env.observationSize()));
+	}
+}
+
+TEST_CASE("Vector env reports halted instances until they're reset", "[NESVectorEnv]")
+{
+	const NESCart jam = nromCart({0xe8, 0x02}); // INX, JAM
+	NESVectorEnv env(jam, 2, NESVectorEnv::Observation::Ram);
+	std::vector<byte> observations(env.size() * env.observationSize());
+	const byte actions[] = {0, 0};
+	env.step(actions, observations.data());
+	REQUIRE(env.halted(0));
+	REQUIRE(env.halted(1));
+
+	env.reset(1);
+	REQUIRE(env.halted(0));
+	REQUIRE_FALSE(env.halted(1));
+
+	REQUIRE_THROWS_AS(NESVectorEnv(jam, 0, NESVectorEnv::Observation::Ram), std::invalid_argument);
+}
@@ -0,0 +1,231 @@
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "catch.hpp"
+
+#include "../src/nescart.hpp"
+#include "../src/romarchive.hpp"
+#include "testcarts.hpp"
+
+namespace
+{
+	enum class ZipMethod
+	{
+		Stored,
+		Deflated,
+		DeflatedWithDescriptor
+	};
+
+	struct ZipEntry
+	{
+		std::string name;
+		std::string data;
+		ZipMethod method;
+	};
+
+	void put16(std::string &out, uint16_t value)
+	{
+		out += static_cast<char>(value & 0xff);
+		out += static_cast<char>(value >> 8);
+	}
+
+	void put32(std::string &out, uint32_t value)
+	{
+		put16(out, value & 0xffff);
+		put16(out, value >> 16);
+	}
+
+	std::string rawDeflate(const std::string &data)
+	{
+		z_stream stream = {};
+		REQUIRE(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+		std::string out(deflateBound(&stream, data.size()), '\0');
+		stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+		stream.avail_in = data.size();
+		stream.next_out = reinterpret_cast<Bytef *>(&out[0]);
+		stream.avail_out = out.size();
+		REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+		out.resize(stream.total_out);
+		deflateEnd(&stream);
+		return out;
+	}
+
+	// a zip archive of the entries, in order, with a central directory
+	std::string zipArchive(const std::vector<ZipEntry> &entries)
+	{
+		std::string archive, directory;
+		for (const ZipEntry &entry : entries)
+		{
+			const bool descriptor = entry.method == ZipMethod::DeflatedWithDescriptor;
+			const uint16_t flags = descriptor ? 1 << 3 : 0;
+			const uint16_t method = entry.method == ZipMethod::Stored ? 0 : 8;
+			const std::string data = method ? rawDeflate(entry.data) : entry.data;
+			const uint32_t crc = crc32(0, reinterpret_cast<const Bytef *>(entry.data.data()), entry.data.size());
+			const uint32_t offset = archive.size();
+
+			// a local header that leaves the sizes to the descriptor has zeroes
+			put32(archive, 0x04034b50);
+			put16(archive, 20);
+			put16(archive, flags);
+			put16(archive, method);
+			put32(archive, 0); // time and date
+			put32(archive, descriptor ? 0 : crc);
+			put32(archive, descriptor ? 0 : data.size());
+			put32(archive, descriptor ? 0 : entry.data.size());
+			put16(archive, entry.name.size());
+			put16(archive, 4);
+			archive += entry.name;
+			put32(archive, 0); // an empty extra field
+			archive += data;
+			if (descriptor)
+			{
+				put32(archive, 0x08074b50);
+				put32(archive, crc);
+				put32(archive, data.size());
+				put32(archive, entry.data.size());
+			}
+
+			put32(directory, 0x02014b50);
+			put16(directory, 20);
+			put16(directory, 20);
+			put16(directory, flags);
+			put16(directory, method);
+			put32(directory, 0);
+			put32(directory, crc);
+			put32(directory, data.size());
+			put32(directory, entry.data.size());
+			put16(directory, entry.name.size());
+			put16(directory, 0);
+			put16(directory, 0);
+			put16(directory, 0); // disk
+			put16(directory, 0); // internal attributes
+			put32(directory, 0); // external attributes
+			put32(directory, offset);
+			directory += entry.name;
+		}
+
+		const uint32_t directoryOffset = archive.size();
+		archive += directory;
+		put32(archive, 0x06054b50);
+		put16(archive, 0);
+		put16(archive, 0);
+		put16(archive, entries.size());
+		put16(archive, entries.size());
+		put32(archive, directory.size());
+		put32(archive, directoryOffset);
+		const std::string comment = "an archive comment";
+		put16(archive, comment.size());
+		archive += comment;
+		return archive;
+	}
+
+	void writeFile(const std::string &path, const std::string &contents)
+	{
+		std::ofstream file(path, std::ios::out | std::ios::binary);
+		file.write(contents.data(), contents.size());
+	}
+
+	// NROM-256 with CHR-ROM, filled with data that doesn't compress to nothing
+	std::string filledRomImage()
+	{
+		std::string image = romImage({2, 1, 0x01}, 2 * prgRomPageSize + chrRomPageSize);
+		uint32_t seed = 1;
+		for (size_t i = 16; i < image.size(); ++i)
+		{
+			seed = seed * 1103515245 + 12345;
+			image[i] = static_cast<char>((seed >> 16) % 24);
+		}
+		return image;
+	}
+
+	// reads the whole stream in a mix of small reads, going through
+	// underflow, and large ones, which inflate straight into the string
+	std::string readAll(std::streambuf &buffer)
+	{
+		std::istream stream(&buffer);
+		std::string out;
+		char small[3];
+		std::vector<char> large(10000);
+		for (bool useLarge = false;; useLarge = !useLarge)
+		{
+			char *into = useLarge ? large.data() : small;
+			stream.read(into, useLarge ? large.size() : sizeof(small));
+			out.append(into, stream.gcount());
+			if (!stream)
+			{
+				return out;
+			}
+		}
+	}
+}
+
+TEST_CASE("Archive formats are told apart by their first bytes", "[RomArchive]")
+{
+	const std::string path = "romarchive_test.bin";
+	writeFile(path, filledRomImage());
+	REQUIRE(detectRomFormat(path) == RomFormat::Plain);
+	writeFile(path, zipArchive({{"game.nes", "NES", ZipMethod::Stored}}));
+	REQUIRE(detectRomFormat(path) == RomFormat::Zip);
+	writeFile(path, "\x1f\x8b");
+	REQUIRE(detectRomFormat(path) == RomFormat::Gzip);
+	writeFile(path, "PK");
+	REQUIRE(detectRomFormat(path) == RomFormat::Plain);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Gzip stream buffers inflate the whole file", "[RomArchive]")
+{
+	const std::string image = filledRomImage();
+	const std::string path = "romarchive_test.nes.gz";
+	gzFile file = gzopen(path.c_str(), "wb");
+	REQUIRE(file != nullptr);
+	REQUIRE(gzwrite(file, image.data(), image.size()) == static_cast<int>(image.size()));
+	gzclose(file);
+
+	GzipStreamBuf gzip(path);
+	REQUIRE(gzip.isOpen());
+	REQUIRE(readAll(gzip) == image);
+
+	const NESCart cart(path);
+	std::remove(path.c_str());
+	REQUIRE(cart.prgRom.size() == 2 * prgRomPageSize);
+	REQUIRE(std::string(cart.prgRom.begin(), cart.prgRom.end()) == image.substr(16, 2 * prgRomPageSize));
+	REQUIRE(std::string(cart.chrRom.begin(), cart.chrRom.end()) == image.substr(16 + 2 * prgRomPageSize));
+}
+
+TEST_CASE("Zip stream buffers read stored and deflated entries", "[RomArchive]")
+{
+	const std::string image = filledRomImage();
+	std::istringstream plainImage(image);
+	const NESCart plain(plainImage);
+	const std::string path = "romarchive_test.zip";
+
+	const ZipMethod methods[] = {ZipMethod::Stored, ZipMethod::Deflated, ZipMethod::DeflatedWithDescriptor};
+	for (ZipMethod method : methods)
+	{
+		// entries that aren't ROMs come first and get skipped
+		writeFile(path, zipArchive({{"readme.txt", "not a ROM", method},
+									{"box.NES.png", "not one either", ZipMethod::Stored},
+									{"dir/Game.NES", image, method},
+									{"other.nes", "NES\x1a", ZipMethod::Stored}}));
+
+		ZipStreamBuf zip(path);
+		REQUIRE(zip.isOpen());
+		REQUIRE(readAll(zip) == image);
+
+		const NESCart cart(path);
+		REQUIRE(cart.prgRom == plain.prgRom);
+		REQUIRE(cart.chrRom == plain.chrRom);
+		REQUIRE(cart.crc == plain.crc);
+	}
+
+	writeFile(path, zipArchive({{"readme.txt", "not a ROM", ZipMethod::Deflated}}));
+	ZipStreamBuf empty(path);
+	REQUIRE_FALSE(empty.isOpen());
+	REQUIRE(readAll(empty).empty());
+	std::remove(path.c_str());
+}
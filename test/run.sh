@@ -1,2 +1,11 @@
 #!/bin/bash
-c++ main.cpp mem_address.cpp nesmemory.cpp -std=c++14 && ./a.out
+# the main suite is built the way the release targets are, the debugger's
+# tests get a binary of their own with the checks compiled in
+c++ main.cpp mem_address.cpp nesmemory.cpp nescart.cpp savefile.cpp crc32.cpp core6502.cpp nescontroller.cpp batchrunner.cpp nesvectorenv.cpp nesfork.cpp movie.cpp romarchive.cpp \
+	../src/nescart.cpp ../src/romarchive.cpp ../src/core6502.cpp ../src/nesapu.cpp ../src/nesppu.cpp \
+	../src/nes.cpp ../src/batchrunner.cpp ../src/nesvectorenv.cpp \
+	-std=c++17 -DCATCH_CONFIG_NO_POSIX_SIGNALS -lz -pthread -o a.out && ./a.out || exit 1
+c++ main.cpp debugger.cpp gdbstub.cpp \
+	../src/nescart.cpp ../src/romarchive.cpp ../src/core6502.cpp ../src/nesapu.cpp ../src/nesppu.cpp \
+	../src/nes.cpp ../src/debugger.cpp ../src/gdbstub.cpp \
+	-std=c++17 -DCATCH_CONFIG_NO_POSIX_SIGNALS -DNESEBAR_DEBUGGER -lz -pthread -o debugger.out && ./debugger.out
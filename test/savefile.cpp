@@ -0,0 +1,29 @@
+#include <cstdio>
+#include <string>
+#include "catch.hpp"
+
+#include "../src/savefile.hpp"
+
+TEST_CASE("Save file contents persist", "[SaveFile]")
+{
+	const std::string path = "savefile_test.sav";
+	std::remove(path.c_str());
+
+	{
+		SaveFile save;
+		REQUIRE(save.open(path, 8192));
+		REQUIRE(save.size() == 8192);
+		REQUIRE(save.data()[0] == 0);
+		save.data()[0] = 0x12;
+		save.data()[8191] = 0x34;
+		save.sync(SaveSync::Sync);
+	}
+
+	SaveFile save;
+	REQUIRE(save.open(path, 8192));
+	REQUIRE(save.data()[0] == 0x12);
+	REQUIRE(save.data()[8191] == 0x34);
+	save.close();
+	REQUIRE(save.data() == nullptr);
+	std::remove(path.c_str());
+}
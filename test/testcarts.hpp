@@ -0,0 +1,58 @@
+#ifndef TESTCARTS_H
+#define TESTCARTS_H
+
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/nescart.hpp"
+
+// an iNES image: "NES\x1a", the rest of the header from header, zero
+// padded, and dataBytes of zeroed PRG and CHR after it
+inline std::string romImage(const std::vector<int> &header, size_t dataBytes)
+{
+	std::string rom = "NES\x1a";
+	for (int field : header)
+	{
+		rom += static_cast<char>(field);
+	}
+	rom.resize(16, 0);
+	rom.resize(16 + dataBytes, 0);
+	return rom;
+}
+
+inline NESCart loadCart(const std::string &image)
+{
+	std::istringstream stream(image);
+	return NESCart(stream);
+}
+
+// NROM-128 running program from $8000, with 8K of zeroed CHR-ROM or, with
+// chrRam, 8K of CHR-RAM. flags are header bytes 6 on, NES 2.0's included.
+inline NESCart nromCart(const std::vector<byte> &program, bool chrRam = false, std::initializer_list<int> flags = {})
+{
+	std::vector<int> header = {1, chrRam ? 0 : 1};
+	header.insert(header.end(), flags.begin(), flags.end());
+	std::string rom = romImage(header, prgRomPageSize + (chrRam ? 0 : chrRomPageSize));
+	rom.replace(16, program.size(), reinterpret_cast<const char *>(program.data()), program.size());
+	rom[16 + 0x3ffc] = 0x00;
+	rom[16 + 0x3ffd] = static_cast<char>(0x80);
+	return loadCart(rom);
+}
+
+// counts the times it sees A held on controller 1 at $00, with INC $00 at
+// $8011 and JMP $8000 after it
+inline NESCart countingCart()
+{
+	return nromCart({
+		0xa9, 0x01, 0x8d, 0x16, 0x40, // LDA #1, STA $4016
+		0xa9, 0x00, 0x8d, 0x16, 0x40, // LDA #0, STA $4016
+		0xad, 0x16, 0x40, 0x29, 0x01, // LDA $4016, AND #1
+		0xf0, 0xef, // BEQ $8000
+		0xe6, 0x00, // INC $00
+		0x4c, 0x00, 0x80 // JMP $8000
+	});
+}
+
+#endif /* TESTCARTS_H */